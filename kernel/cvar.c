@@ -14,6 +14,7 @@
  */
 typedef struct cvar {
     int cvar_id;
+    pcb_queue_t waiters;        // Processes blocked waiting on the cvar (FIFO)
     struct cvar *next;
     struct cvar *prev;
 } cvar_t;
@@ -24,6 +25,12 @@ typedef struct cvar_list {
 } cvar_list_t;
 
 
+/*
+ * Local Global Variable Definitions
+ */
+static slab_cache_t g_cvar_cache = SLAB_CACHE_INIT("cvar_t", sizeof(cvar_t), NULL);
+
+
 /*
  * Local Function Definitions
  */
@@ -68,7 +75,7 @@ int CVarListDelete(cvar_list_t *_cl) {
     cvar_t *cvar = _cl->start;
     while (cvar) {
         cvar_t *next = cvar->next;
-        free(cvar);
+        SlabFree(&g_cvar_cache, cvar);
         cvar = next;
     }
     free(_cl);
@@ -103,10 +110,10 @@ int CVarInit(cvar_list_t *_cl, int *_cvar_id, int check_addr_flag) {
     //    (i.e., in valid pages) with write permissions so we can write the cvar id there.
     int ret;
     if (check_addr_flag) {
-        ret = PTECheckAddress(running_old->pt,
-                              _cvar_id,
-                              sizeof(int),
-                              PROT_WRITE);
+        ret = ProcessCheckAddress(running_old,
+                                  _cvar_id,
+                                  sizeof(int),
+                                  PROT_WRITE);
         if (ret < 0) {
             TracePrintf(1, "[CVarInit] _cvar_id pointer is not within valid address space\n");
             return ERROR;
@@ -114,7 +121,7 @@ int CVarInit(cvar_list_t *_cl, int *_cvar_id, int check_addr_flag) {
     }
 
     // 4. Allocate space for a new cvar struct
-    cvar_t *cvar = (cvar_t *) malloc(sizeof(cvar_t));
+    cvar_t *cvar = (cvar_t *) SlabAlloc(&g_cvar_cache);
     if (!cvar) {
         TracePrintf(1, "[CVarInit] Error mallocing space for cvar struct\n");
         return ERROR;
@@ -124,9 +131,11 @@ int CVarInit(cvar_list_t *_cl, int *_cvar_id, int check_addr_flag) {
     cvar->cvar_id   = CVarIDFindAndSet();
     if (cvar->cvar_id == ERROR) {
         TracePrintf(1, "[CVarInit] Failed to find a valid cvar_id.\n");
-        free(cvar);
+        SlabFree(&g_cvar_cache, cvar);
         return ERROR;
     }
+    cvar->waiters.start = NULL;
+    cvar->waiters.end   = NULL;
     cvar->next      = NULL;
     cvar->prev      = NULL;
 
@@ -137,7 +146,7 @@ int CVarInit(cvar_list_t *_cl, int *_cvar_id, int check_addr_flag) {
     // 7. Add the cvar to the process's resource list
     if (list_append(running_old->res_list, cvar->cvar_id, NULL) == ERROR) {
         CVarRemove(_cl, cvar->cvar_id);
-        free(cvar);
+        SlabFree(&g_cvar_cache, cvar);
         return ERROR;
     }
     return 0;
@@ -171,7 +180,7 @@ int CVarSignal(cvar_list_t *_cl, int _cvar_id) {
         TracePrintf(1, "[CVarSignal] CVar: %d not found in ll list\n", _cvar_id);
         return ERROR;
     }
-    SchedulerUpdateCVar(e_scheduler, _cvar_id);
+    SchedulerUpdateCVar(e_scheduler, &cvar->waiters);
     return 0;
 }
 
@@ -204,13 +213,8 @@ int CVarBroadcast(cvar_list_t *_cl, int _cvar_id) {
         return ERROR;
     }
 
-    // 3. I coded UpdateCVar to return ERROR if it does not find any process waiting on the
-    //    cvar specified by _cvar_id. Thus, we just loop as long is it returns 0 to unblock
-    //    all of the processes waiting on cvar (i.e., broadcast).
-    int ret = SchedulerUpdateCVar(e_scheduler, _cvar_id);
-    while (ret == 0) {
-        ret = SchedulerUpdateCVar(e_scheduler, _cvar_id);
-    }
+    // 3. Move every process waiting on the cvar over to the ready list in one pass.
+    SchedulerUpdateCVarAll(e_scheduler, &cvar->waiters);
     return 0;
 }
 
@@ -239,7 +243,14 @@ int CVarWait(cvar_list_t *_cl, UserContext *_uctxt, int _cvar_id, int _lock_id)
         return ERROR;
     }
 
-    // 2. Release the lock. If this fails for any reason (e.g., lock is already free or the
+    // 2. Grab the struct for the cvar specified by cvar_id. If its not found, return ERROR.
+    cvar_t *cvar = CVarGet(_cl, _cvar_id);
+    if (!cvar) {
+        TracePrintf(1, "[CVarWait] CVar: %d not found in cl list\n", _cvar_id);
+        return ERROR;
+    }
+
+    // 3. Release the lock. If this fails for any reason (e.g., lock is already free or the
     //    the current process does not hold it) return an ERROR and do not continue.
     int ret = LockRelease(e_lock_list, _lock_id);
     if (ret < 0) {
@@ -247,22 +258,21 @@ int CVarWait(cvar_list_t *_cl, UserContext *_uctxt, int _cvar_id, int _lock_id)
         return ERROR;
     }
 
-    // 3. Get the pcb for the current running process.
+    // 4. Get the pcb for the current running process.
     pcb_t *running_old = SchedulerGetRunning(e_scheduler);
     if (!running_old) {
         TracePrintf(1, "[CVarWait] e_scheduler returned no running process\n");
         Halt();
     }
 
-    // 4. Mark that the current process is waiting on _cvar_id and add it to our blocked list.
+    // 5. Add the current process to the cvar's wait queue and switch to the next ready process.
     TracePrintf(1, "[CVarWait] Waiting on _cvar_id: %d for _lock_id: %d. Blocking process: %d\n",
                                   _cvar_id, _lock_id, running_old->pid);
-    running_old->cvar_id = _cvar_id;
     memcpy(&running_old->uctxt, _uctxt, sizeof(UserContext));
-    SchedulerAddCVar(e_scheduler, running_old);
+    SchedulerAddCVar(e_scheduler, &cvar->waiters, running_old);
     KCSwitch(_uctxt, running_old);
 
-    // 5. If we are here it is because the process has been woken up by a CVarSignal. Now we
+    // 6. If we are here it is because the process has been woken up by a CVarSignal. Now we
     //    should re-acquire the lock before returning to normal process execution. If this
     //    fails for any reason, however, return an ERROR.
     ret = LockAcquire(e_lock_list, _uctxt, _lock_id);
@@ -292,6 +302,14 @@ int CVarReclaim(cvar_list_t *_cl, int _cvar_id) {
         return ERROR;
     }
 
+    // Refuse to free the cvar while processes are still waiting on it, since their pcbs are
+    // linked into the cvar's wait queue.
+    cvar_t *cvar = CVarGet(_cl, _cvar_id);
+    if (cvar && cvar->waiters.start) {
+        TracePrintf(1, "[CVarReclaim] CVar %d still has waiting processes\n", _cvar_id);
+        return ERROR;
+    }
+
     // Remove the cvar from the list and free its resources
     if (CVarRemove(_cl, _cvar_id) == ERROR) {
         helper_abort("[CvarReclaim] CVar remove failed.\n");
@@ -404,7 +422,7 @@ static int CVarRemove(cvar_list_t *_cl, int _cvar_id) {
         if (_cl->start) {
             _cl->start->prev = NULL;
         }
-        free(cvar);
+        SlabFree(&g_cvar_cache, cvar);
         return 0;
     }
 
@@ -413,7 +431,7 @@ static int CVarRemove(cvar_list_t *_cl, int _cvar_id) {
     if (cvar->cvar_id == _cvar_id) {
         _cl->end       = cvar->prev;
         _cl->end->next = NULL;
-        free(cvar);
+        SlabFree(&g_cvar_cache, cvar);
         return 0;
     }
 
@@ -425,7 +443,7 @@ static int CVarRemove(cvar_list_t *_cl, int _cvar_id) {
         if (cvar->cvar_id == _cvar_id) {
             cvar->prev->next = cvar->next;
             cvar->next->prev = cvar->prev;
-            free(cvar);
+            SlabFree(&g_cvar_cache, cvar);
             return 0;
         }
         cvar = cvar->next;
@@ -1,6 +1,10 @@
 #include "dllist.h"
 #include <ylib.h>
 #include <ykernel.h>
+#include "slab.h"
+
+static slab_cache_t g_dlnode_cache = SLAB_CACHE_INIT("dlnode_t", sizeof(dlnode_t), NULL);
+static slab_cache_t g_dllist_cache = SLAB_CACHE_INIT("dllist", sizeof(dllist), NULL);
 
 int empty(dllist *l)
 {
@@ -15,7 +19,7 @@ void list_delete_node(dlnode_t *node)
     node->next->prev = node->prev;
     node->prev->next = node->next;
     free(node->data);
-    free(node);
+    SlabFree(&g_dlnode_cache, node);
 }
 
 dlnode_t *first(dllist *l) {
@@ -40,7 +44,7 @@ dlnode_t *list_insert_before(dlnode_t *node, int key, void *data)
     dlnode_t *newnode;
     dlnode_t *prev_node = node->prev;
 
-    newnode = (dlnode_t *) malloc (sizeof(dlnode_t));
+    newnode = (dlnode_t *) SlabAlloc(&g_dlnode_cache);
     if (newnode == NULL) {
         TracePrintf(1, "list_insert_before failed!\n");
         return NULL;
@@ -72,11 +76,11 @@ dllist *list_new()
     dllist *d;
     dlnode_t *node;
 
-    d = (dllist *) malloc (sizeof(dllist));
+    d = (dllist *) SlabAlloc(&g_dllist_cache);
     if (!d) return NULL;
-    node = (dlnode_t *) malloc(sizeof(dlnode_t));
+    node = (dlnode_t *) SlabAlloc(&g_dlnode_cache);
     if (!node) {
-        free(d);
+        SlabFree(&g_dllist_cache, d);
         return NULL;
     }
 
@@ -91,8 +95,8 @@ void list_free(dllist *l)
     while (!empty(l)) {
         list_delete_node(first(l));
     }
-    free(l->sentinel_node);
-    free(l);
+    SlabFree(&g_dlnode_cache, l->sentinel_node);
+    SlabFree(&g_dllist_cache, l);
 }
 
 dlnode_t *list_find(dllist *list, int key) {
@@ -1,5 +1,7 @@
 #include "frame.h"
 #include "kernel.h"
+#include "pte.h"
+#include "swap.h"
 #include "ykernel.h"
 
 //Bit Manipulation: http://www.mathcs.emory.edu/~cheung/Courses/255/Syllabus/1-C-intro/Progs/bit-array2.c
@@ -8,9 +10,55 @@
 #define BitTest(A,k)  ( A[(k/KERNEL_BYTE_SIZE)] &   (1 << (k%KERNEL_BYTE_SIZE)) )
 
 
+/*
+ * Local Global Variable Definitions - Free frames are kept on a stack so that allocating and
+ * freeing a frame are both O(1). g_free_index maps a frame to its slot on the stack (or -1 if
+ * the frame is in use) so that FrameSet can pull an arbitrary frame off of the stack as well.
+ *
+ * Free frames that idle has already zeroed are kept off of the free stack in a separate pool.
+ * They are still free (their bit is clear), so FrameFindAndSet falls back to them when the free
+ * stack runs dry, and FrameSet pulls them out of the pool.
+ */
+static int *g_free_stack = NULL;
+static int *g_free_index = NULL;
+static int  g_free_count = 0;
+static int  g_zero_pool[FRAME_ZERO_POOL_MAX];
+static int  g_zero_count = 0;
+
+static void FramePush(int _frame_num);
+static void FrameRemove(int _frame_num);
+static int  FrameZero(int _frame_num);
+
+
 /*!
- * \desc                 Marks the frame indicated by "_frame_num" as free by clearing its bit
- *                       in our global frame bit vector.
+ * \desc                  Initializes the free frame stack with every frame in physical memory.
+ *                        This must be called once at boot (after e_num_frames is known) before
+ *                        any other Frame function.
+ *
+ * \return                0 on success, ERROR otherwise.
+ */
+int FrameInit() {
+    // 1. Allocate space for our free stack and the index of each frame on it.
+    g_free_stack = (int *) malloc(e_num_frames * sizeof(int));
+    g_free_index = (int *) malloc(e_num_frames * sizeof(int));
+    if (!g_free_stack || !g_free_index) {
+        TracePrintf(1, "[FrameInit] Error mallocing space for free frame stack\n");
+        return ERROR;
+    }
+
+    // 2. Push every frame, highest first, so that low frames are handed out first like before.
+    g_free_count = 0;
+    for (int i = e_num_frames - 1; i >= 0; i--) {
+        FramePush(i);
+    }
+    return 0;
+}
+
+
+/*!
+ * \desc                 Drops a reference to the frame indicated by "_frame_num". If that was the
+ *                       last reference, the frame is marked as free by clearing its bit in our
+ *                       global frame bit vector. Otherwise, it stays in use by its other sharers.
  * 
  * \param[in] _frame_num  The number of the frame to free
  * 
@@ -33,10 +81,20 @@ int FrameClear(int _frame_num) {
     //    If so, print a warning message but do not return ERROR.
     if(!BitTest(e_frames, _frame_num)) {
         TracePrintf(1, "[FrameClear] Warning: frame %d is already invalid\n", _frame_num);
+        return 0;
     }
 
-    // 4. "Free" the frame indicated by _frame_num by clearing its bit in our frames bit vector.
+    // 4. If the frame is still shared with another page table, simply drop our reference.
+    if (e_frame_refs[_frame_num] > 1) {
+        e_frame_refs[_frame_num]--;
+        return 0;
+    }
+
+    // 5. "Free" the frame indicated by _frame_num by clearing its bit in our frames bit vector
+    //    and pushing it back onto our free stack.
+    e_frame_refs[_frame_num] = 0;
     BitClear(e_frames, _frame_num);
+    FramePush(_frame_num);
     return 0;
 }
 
@@ -53,15 +111,142 @@ int FrameFindAndSet() {
         Halt();
     }
 
-    // 2. Loop over the frame bit vector and return the index of the first free frame
-    //    we find. If we make it through the loop, there must not be any free frames.
-    for (int i = 0; i < e_num_frames; i++) {
-        if (BitTest(e_frames, i) == 0) {
-            BitSet(e_frames, i);
-            return i;
+    // 2. Pop a frame off of our free stack. If the stack is empty, take one that has already been
+    //    zeroed. If there are none of those either, try to have the swapper evict a page to free
+    //    one up. If it can't, there are no free frames.
+    if (!g_free_count && !g_zero_count) {
+        SwapEvict();
+    }
+    int frame_num;
+    if (g_free_count) {
+        frame_num = g_free_stack[g_free_count - 1];
+        FrameRemove(frame_num);
+    } else if (g_zero_count) {
+        frame_num = g_zero_pool[--g_zero_count];
+    } else {
+        return ERROR;
+    }
+    BitSet(e_frames, frame_num);
+    e_frame_refs[frame_num] = 1;
+    return frame_num;
+}
+
+
+/*!
+ * \desc                 Allocates _num free frames at once. Either all of the frames are
+ *                       allocated or, if there are not enough free frames, none of them are.
+ *
+ * \param[in]  _num      The number of frames to allocate
+ * \param[out] _frames   An array of at least _num ints to store the frame numbers in
+ *
+ * \return               0 on success, ERROR otherwise.
+ */
+int FrameAllocN(int _num, int *_frames) {
+    // 1. Check arguments. Return error if invalid.
+    if (_num < 0 || (_num && !_frames)) {
+        TracePrintf(1, "[FrameAllocN] Invalid arguments\n");
+        return ERROR;
+    }
+
+    // 2. Make sure there are enough free frames up front so we never allocate only some of them,
+    //    having the swapper evict pages for as long as it can if there are not.
+    while (_num > g_free_count + g_zero_count && SwapEvict() == 0) {}
+    if (_num > g_free_count + g_zero_count) {
+        TracePrintf(1, "[FrameAllocN] Only %d free frames for %d\n",
+                                      g_free_count + g_zero_count, _num);
+        return ERROR;
+    }
+    for (int i = 0; i < _num; i++) {
+        _frames[i] = FrameFindAndSet();
+    }
+    return 0;
+}
+
+
+/*!
+ * \desc    Finds a free frame whose contents are all zeroes, for pages that must start out
+ *          zeroed. Frames come from the pool that idle keeps filled when possible; otherwise we
+ *          zero a free frame ourselves.
+ *
+ * \return  Frame number on success, ERROR otherwise.
+ */
+int FrameAllocZero() {
+    // 1. Take a frame from the zeroed pool if there is one.
+    if (g_zero_count) {
+        int frame_num = g_zero_pool[--g_zero_count];
+        BitSet(e_frames, frame_num);
+        e_frame_refs[frame_num] = 1;
+        return frame_num;
+    }
+
+    // 2. Otherwise, allocate any free frame and zero it now.
+    int frame_num = FrameFindAndSet();
+    if (frame_num == ERROR) {
+        return ERROR;
+    }
+    if (FrameZero(frame_num) == ERROR) {
+        FrameClear(frame_num);
+        return ERROR;
+    }
+    return frame_num;
+}
+
+
+/*!
+ * \desc                 Allocates _num zeroed frames at once (see FrameAllocN and FrameAllocZero).
+ *
+ * \param[in]  _num      The number of frames to allocate
+ * \param[out] _frames   An array of at least _num ints to store the frame numbers in
+ *
+ * \return               0 on success, ERROR otherwise.
+ */
+int FrameAllocZeroN(int _num, int *_frames) {
+    // 1. Check arguments. Return error if invalid.
+    if (_num < 0 || (_num && !_frames)) {
+        TracePrintf(1, "[FrameAllocZeroN] Invalid arguments\n");
+        return ERROR;
+    }
+
+    // 2. Make sure there are enough free frames up front so we never allocate only some of them,
+    //    having the swapper evict pages for as long as it can if there are not.
+    while (_num > g_free_count + g_zero_count && SwapEvict() == 0) {}
+    if (_num > g_free_count + g_zero_count) {
+        TracePrintf(1, "[FrameAllocZeroN] Only %d free frames for %d\n",
+                                          g_free_count + g_zero_count, _num);
+        return ERROR;
+    }
+    for (int i = 0; i < _num; i++) {
+        _frames[i] = FrameAllocZero();
+        if (_frames[i] == ERROR) {
+            FrameFreeN(i, _frames);
+            return ERROR;
+        }
+    }
+    return 0;
+}
+
+
+/*!
+ * \desc                 Drops a reference to each of _num frames (see FrameClear).
+ *
+ * \param[in] _num       The number of frames to free
+ * \param[in] _frames    An array of _num frame numbers
+ *
+ * \return               0 on success, ERROR otherwise.
+ */
+int FrameFreeN(int _num, int *_frames) {
+    // 1. Check arguments. Return error if invalid.
+    if (_num < 0 || (_num && !_frames)) {
+        TracePrintf(1, "[FrameFreeN] Invalid arguments\n");
+        return ERROR;
+    }
+    int ret = 0;
+    for (int i = 0; i < _num; i++) {
+        if (FrameClear(_frames[i]) == ERROR) {
+            ret = ERROR;
         }
     }
-    return ERROR;
+    return ret;
 }
 
 
@@ -90,10 +275,124 @@ int FrameSet(int _frame_num) {
     //    If so, print a warning message but do not return ERROR.
     if(BitTest(e_frames, _frame_num)) {
         TracePrintf(1, "[FrameSet] Warning: frame %d is already valid\n", _frame_num);
+        return 0;
     }
 
-    // 4. Mark the frame indicated by _frame_num as in use by
-    //    setting its bit in the frame bit vector.
+    // 4. Mark the frame indicated by _frame_num as in use by setting its bit in the frame
+    //    bit vector and pulling it off of our free stack (or out of the zeroed pool).
+    if (g_free_index[_frame_num] != -1) {
+        FrameRemove(_frame_num);
+    } else {
+        for (int i = 0; i < g_zero_count; i++) {
+            if (g_zero_pool[i] == _frame_num) {
+                g_zero_pool[i] = g_zero_pool[--g_zero_count];
+                break;
+            }
+        }
+    }
     BitSet(e_frames, _frame_num);
+    e_frame_refs[_frame_num] = 1;
+    return 0;
+}
+
+
+/*!
+ * \desc                 Adds a reference to a frame that is already in use so that it can be
+ *                       mapped into another page table (e.g., shared copy-on-write by fork).
+ * 
+ * \param[in] _frame_num  The number of the frame to share
+ * 
+ * \return               0 on success, ERROR otherwise.
+ */
+int FrameRef(int _frame_num) {
+    // 1. Check that our frame number is valid. If not, print message and return error.
+    if (_frame_num < 0 || _frame_num >= e_num_frames) {
+        TracePrintf(1, "[FrameRef] Invalid frame number: %d\n", _frame_num);
+        return ERROR;
+    }
+
+    // 2. Only frames that are in use can be shared.
+    if (!BitTest(e_frames, _frame_num)) {
+        TracePrintf(1, "[FrameRef] Frame %d is not in use\n", _frame_num);
+        return ERROR;
+    }
+    e_frame_refs[_frame_num]++;
+    return 0;
+}
+
+
+/*!
+ * \desc                 Returns the number of page table entries currently mapping a frame.
+ * 
+ * \param[in] _frame_num  The number of the frame to check
+ * 
+ * \return               The reference count on success, ERROR otherwise.
+ */
+int FrameRefCount(int _frame_num) {
+    // 1. Check that our frame number is valid. If not, print message and return error.
+    if (_frame_num < 0 || _frame_num >= e_num_frames) {
+        TracePrintf(1, "[FrameRefCount] Invalid frame number: %d\n", _frame_num);
+        return ERROR;
+    }
+    return e_frame_refs[_frame_num];
+}
+
+
+/*!
+ * \desc    Zeroes up to FRAME_ZERO_PER_TICK free frames and moves them into the zeroed pool. This
+ *          is called on clock ticks while idle is running, so that the zeroing happens when the
+ *          machine has nothing better to do rather than when a process faults or execs.
+ *
+ * \return  The number of frames zeroed.
+ */
+int FrameZeroIdle() {
+    int num_zeroed = 0;
+    while (num_zeroed < FRAME_ZERO_PER_TICK &&
+           g_zero_count < FRAME_ZERO_POOL_MAX && g_free_count) {
+        int frame_num = g_free_stack[g_free_count - 1];
+        if (FrameZero(frame_num) == ERROR) {
+            break;
+        }
+        FrameRemove(frame_num);
+        g_zero_pool[g_zero_count++] = frame_num;
+        num_zeroed++;
+    }
+    return num_zeroed;
+}
+
+
+static void FramePush(int _frame_num) {
+    // 1. Put the frame on top of the free stack and remember where it is.
+    g_free_index[_frame_num]   = g_free_count;
+    g_free_stack[g_free_count] = _frame_num;
+    g_free_count++;
+}
+
+
+static void FrameRemove(int _frame_num) {
+    // 1. Move the frame on top of the stack into the removed frame's slot, then shrink the stack.
+    //    When removing the top frame (the common case) this just pops it.
+    int slot = g_free_index[_frame_num];
+    int top  = g_free_stack[g_free_count - 1];
+    g_free_stack[slot]       = top;
+    g_free_index[top]        = slot;
+    g_free_index[_frame_num] = -1;
+    g_free_count--;
+}
+
+
+static int FrameZero(int _frame_num) {
+    // 1. Temporarily map the frame to the page right below the kernel stack (making sure the
+    //    kernel heap has not grown into it), zero it through that mapping, then unmap it.
+    int   temp_page_num  = (KERNEL_STACK_BASE >> PAGESHIFT) - 1;
+    void *temp_page_addr = (void *) (temp_page_num << PAGESHIFT);
+    if (temp_page_addr < e_kernel_curr_brk) {
+        TracePrintf(1, "[FrameZero] Kernel heap overlaps the temporary page\n");
+        return ERROR;
+    }
+    PTESet(e_kernel_pt, temp_page_num, PROT_READ | PROT_WRITE, _frame_num);
+    bzero(temp_page_addr, PAGESIZE);
+    PTEClear(e_kernel_pt, temp_page_num);
+    WriteRegister(REG_TLB_FLUSH, (unsigned int) temp_page_addr);
     return 0;
-}
\ No newline at end of file
+}
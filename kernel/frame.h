@@ -1,7 +1,21 @@
 #ifndef __FRAME_H
 #define __FRAME_H
 
+// Free frames are zeroed in the background while idle runs (see FrameZeroIdle) and kept in a
+// pool of up to FRAME_ZERO_POOL_MAX frames, so that pages that must start out zeroed (stack,
+// bss, and heap) usually do not have to be zeroed when they are allocated.
+#define FRAME_ZERO_POOL_MAX   64
+#define FRAME_ZERO_PER_TICK   8
+
+int FrameAllocN(int _num, int *_frames);
+int FrameAllocZero(void);
+int FrameAllocZeroN(int _num, int *_frames);
 int FrameClear(int _frame_num);
 int FrameFindAndSet(void);
+int FrameFreeN(int _num, int *_frames);
+int FrameInit(void);
+int FrameRef(int _frame_num);
+int FrameRefCount(int _frame_num);
 int FrameSet(int _frame_num);
-#endif // __FRAME_H
\ No newline at end of file
+int FrameZeroIdle(void);
+#endif // __FRAME_H
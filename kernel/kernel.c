@@ -13,16 +13,19 @@
 #include "syscall.h"
 #include "trap.h"
 #include "semaphore.h"
+#include "swap.h"
 
 /*
  * Extern Global Variable Definitions
  */
 char        *e_frames           = NULL;   // Bit vector to track frames (set in KernelStart)
+unsigned short *e_frame_refs    = NULL;   // Per-frame reference counts (set in KernelStart)
 int          e_num_frames       = 0;      // Number of frames           (set in KernelStart)
 cvar_list_t *e_cvar_list        = NULL;
 lock_list_t *e_lock_list        = NULL;
 pipe_list_t *e_pipe_list        = NULL;
 scheduler_t *e_scheduler        = NULL;
+slab_cache_t e_kctxt_cache      = SLAB_CACHE_INIT("KernelContext", sizeof(KernelContext), NULL);
 pte_t       *e_kernel_pt        = NULL;
 tty_list_t  *e_tty_list         = NULL;
 void        *e_kernel_curr_brk  = NULL;
@@ -55,7 +58,8 @@ static void *g_interrupt_table[TRAP_VECTOR_SIZE] = {
 /*
  * Local Function Definitions
  */
-static void DoIdle(void);
+static void   DoIdle(void);
+static char **KernelParseBootFlags(char **_cmd_args);
 
 
 /*!
@@ -146,8 +150,11 @@ int SetKernelBrk(void *_kernel_new_brk) {
             int frame_num = e_kernel_pt[cur_brk_page_num - i].pfn;
             FrameClear(frame_num);
 
-            // 6d. Clear the page in the kernel's page table so it is no longer valid
+            // 6d. Clear the page in the kernel's page table so it is no longer valid, and flush
+            //     just that page from the TLB. Pages we add were invalid before, so growing the
+            //     heap never leaves a stale entry behind and needs no flush at all.
             PTEClear(e_kernel_pt, cur_brk_page_num - i);
+            WriteRegister(REG_TLB_FLUSH, (unsigned int) ((cur_brk_page_num - i) << PAGESHIFT));
             TracePrintf(1, "[SetKernelBrk] Unmapping page: %d from frame: %d\n",
                            cur_brk_page_num - i, frame_num);
         }
@@ -159,7 +166,6 @@ int SetKernelBrk(void *_kernel_new_brk) {
     TracePrintf(1, "[SetKernelBrk] _kernel_new_brk:   %p\n", _kernel_new_brk);
     TracePrintf(1, "[SetKernelBrk] e_kernel_curr_brk: %p\n", e_kernel_curr_brk);
     e_kernel_curr_brk = _kernel_new_brk;
-    WriteRegister(REG_TLB_FLUSH, TLB_FLUSH_ALL);
     return 0;
 }
 
@@ -170,7 +176,8 @@ int SetKernelBrk(void *_kernel_new_brk) {
  *                        we setup the kernel's page table and a dummy "DoIdle" process to run
  *                        when no other processes are available.
  * 
- * \param[in] _cmd_args   Not used for checkpoint 2
+ * \param[in] _cmd_args   Leading key=value boot flags (e.g., sched=stride), followed by the init
+ *                        program and its arguments (defaults to ./user/init)
  * \param[in] _pmem_size  The size of the physical memory availabe to our system (in bytes)
  * \param[in] _uctxt      An initialized usercontext struct for the DoIdle process
  */
@@ -208,6 +215,21 @@ void KernelStart(char **_cmd_args, unsigned int _pmem_size, UserContext *_uctxt)
         Halt();
     }
 
+    //    Frames can be shared between processes (e.g., copy-on-write after fork), so we also keep
+    //    a reference count per frame. A frame is only freed once its last reference is dropped.
+    e_frame_refs = (unsigned short *) calloc(e_num_frames, sizeof(unsigned short));
+    if (!e_frame_refs) {
+        TracePrintf(1, "Calloc for e_frame_refs failed!\n");
+        Halt();
+    }
+
+    //    Finally, put every frame on our free frame stack, which makes allocating and freeing
+    //    frames O(1). Frames used by the kernel itself are pulled off of it below by FrameSet.
+    if (FrameInit() == ERROR) {
+        TracePrintf(1, "[KernelStart] Failed to initialize free frame stack\n");
+        Halt();
+    }
+
     // 5. Allocate space for our lock list struct, which we use to manage our locks.
     e_cvar_list = CVarListCreate();
     if (!e_cvar_list) {
@@ -236,12 +258,15 @@ void KernelStart(char **_cmd_args, unsigned int _pmem_size, UserContext *_uctxt)
         Halt();
     }
 
-    // 8. Allocate space for our scheduler struct, which we will use to track processes.
+    // 8. Allocate space for our scheduler struct, which we will use to track processes. Then
+    //    consume any boot flags at the front of our command line arguments (e.g., the scheduling
+    //    policy to use). Whatever is left is the init program and its arguments.
     e_scheduler = SchedulerCreate();
     if (!e_scheduler) {
         TracePrintf(1, "[KernelStart] Failed to create e_scheduler\n");
         Halt();
     }
+    char **init_args = KernelParseBootFlags(_cmd_args);
 
     // 9. Allocate space for our tty struct, which we use to read and write to tty devices.
     e_tty_list = TTYListCreate();
@@ -289,7 +314,7 @@ void KernelStart(char **_cmd_args, unsigned int _pmem_size, UserContext *_uctxt)
     //     plan to run the idle program first and have init clone into idle later during a
     //     context switch. More specifically, our context switching code will see that init's
     //     KC is NULL and call KCCopy to copy the KernelContext of the current running process.
-    idlePCB->kctxt = (KernelContext *) malloc(sizeof(KernelContext));
+    idlePCB->kctxt = (KernelContext *) SlabAlloc(&e_kctxt_cache);
     if (!idlePCB->kctxt) {
         TracePrintf(1, "[KernelStart] Malloc for idlePCB kctxt failed\n");
         Halt();
@@ -396,10 +421,13 @@ void KernelStart(char **_cmd_args, unsigned int _pmem_size, UserContext *_uctxt)
         TracePrintf(1, "[KernelStart] Unable to find free frame for DoIdle userstack!\n");
         Halt();
     }
-    PTESet(idlePCB->pt,               // page table pointer
-           user_stack_page_num,       // page number
-           PROT_READ | PROT_WRITE,    // page protection bits
-           user_stack_frame_num);     // frame number
+    if (ProcessPTESet(idlePCB,                          // process
+                      user_stack_page_num,              // page number
+                      PROT_READ | PROT_WRITE,           // page protection bits
+                      user_stack_frame_num) == ERROR) { // frame number
+        TracePrintf(1, "[KernelStart] Unable to map DoIdle userstack!\n");
+        Halt();
+    }
 
     // 20. Note that *every* process has a kernel stack, but the kernel only ever uses the one for
     //     the current running process. Thus, whenever we switch processes we need to remember to
@@ -423,7 +451,7 @@ void KernelStart(char **_cmd_args, unsigned int _pmem_size, UserContext *_uctxt)
     //     SetKernalBrk knows to treat addresses as virtual from now on.
     WriteRegister(REG_PTBR0,       (unsigned int) e_kernel_pt);         // kernel pt address
     WriteRegister(REG_PTLR0,       (unsigned int) MAX_PT_LEN);          // num entries
-    WriteRegister(REG_PTBR1,       (unsigned int) initPCB->pt);         // idle pt address
+    WriteRegister(REG_PTBR1,       (unsigned int) ProcessPTELoad(initPCB)); // init pt address
     WriteRegister(REG_PTLR1,       (unsigned int) MAX_PT_LEN);          // num entries
     WriteRegister(REG_VECTOR_BASE, (unsigned int) g_interrupt_table);   // IV address
     WriteRegister(REG_VM_ENABLE, 1);
@@ -436,10 +464,10 @@ void KernelStart(char **_cmd_args, unsigned int _pmem_size, UserContext *_uctxt)
     //     table accordingly. Then it will load the programs code and data into said frames.
     //     Additionally, it will set the brk and data_end variables in inits pcb.
     int ret;
-    if (!_cmd_args[0]) {
-        ret = LoadProgram("./user/init", _cmd_args, initPCB);
+    if (!init_args[0]) {
+        ret = LoadProgram("./user/init", init_args, initPCB);
     } else {
-        ret = LoadProgram(_cmd_args[0], _cmd_args, initPCB);
+        ret = LoadProgram(init_args[0], init_args, initPCB);
     }
     if (ret < 0) {
         TracePrintf(1, "Error loading init program\n");
@@ -460,7 +488,7 @@ void KernelStart(char **_cmd_args, unsigned int _pmem_size, UserContext *_uctxt)
 
     // 24. Finally, now that we have loaded init, reset the TLB region 1 page table to use idle's
     //     page table entries since idle is the process that is about to run.
-    WriteRegister(REG_PTBR1,    (unsigned int) idlePCB->pt);    // idle pt address
+    WriteRegister(REG_PTBR1,    (unsigned int) ProcessPTELoad(idlePCB));    // idle pt address
     WriteRegister(REG_PTLR1,    (unsigned int) MAX_PT_LEN);     // num entries
     WriteRegister(REG_TLB_FLUSH, TLB_FLUSH_1);
 
@@ -468,8 +496,7 @@ void KernelStart(char **_cmd_args, unsigned int _pmem_size, UserContext *_uctxt)
     TracePrintf(1, "[KernelStart] e_num_frames:                %d\n", e_num_frames);
     TracePrintf(1, "[KernelStart] e_frames:                    %p\n", e_frames);
     TracePrintf(1, "[KernelStart] e_kernel_pt:                 %p\n", e_kernel_pt);
-    TracePrintf(1, "[KernelStart] idlePCB->pt:                 %p\n", idlePCB->pt);
-    TracePrintf(1, "[KernelStart] initPCB->pt:                 %p\n", initPCB->pt);
+    TracePrintf(1, "[KernelStart] region 1 pt:                 %p\n", ProcessPTELoad(idlePCB));
     TracePrintf(1, "[KernelStart] kernel_text_end_page_num:    %d\n", kernel_text_end_page_num);
     TracePrintf(1, "[KernelStart] kernel_data_end_page_num:    %d\n", kernel_data_end_page_num);
     TracePrintf(1, "[KernelStart] kernel_heap_end_page_num:    %d\n", kernel_heap_end_page_num);
@@ -480,6 +507,7 @@ void KernelStart(char **_cmd_args, unsigned int _pmem_size, UserContext *_uctxt)
     TracePrintf(1, "[KernelStart] idlePCB->pid:                %d\n", idlePCB->pid);
     TracePrintf(1, "[KernelStart] initPCB->pid:                %d\n", initPCB->pid);
     SchedulerPrintProcess(e_scheduler);
+    SlabPrint(NULL);
 }
 
 
@@ -560,7 +588,7 @@ KernelContext *KCCopy(KernelContext *_kctxt, void *_new_pcb_p, void *_not_used)
     // 2. Cast our void arguments to our custom pcb struct. Allocate space for
     //    a KernelContext then copy over the incoming context. Halt upon error.
     pcb_t *running_new = (pcb_t *) _new_pcb_p;
-    running_new->kctxt = (KernelContext *) malloc(sizeof(KernelContext));
+    running_new->kctxt = (KernelContext *) SlabAlloc(&e_kctxt_cache);
     if (!running_new->kctxt) {
         TracePrintf(1, "[MyKCCopy] Error allocating space for KernelContext\n");
         Halt();
@@ -602,11 +630,13 @@ KernelContext *KCCopy(KernelContext *_kctxt, void *_new_pcb_p, void *_not_used)
         kernel_stack_temp_addr += PAGESIZE;
     }
 
-    // 5. Unmap the temporary stack pages from the next processes stack frames.
+    // 5. Unmap the temporary stack pages from the next processes stack frames. Only these pages
+    //    changed, so flush them individually rather than throwing away the whole TLB.
     for (int i = 0; i < KERNEL_NUMBER_STACK_FRAMES; i++) {
         PTEClear(e_kernel_pt, i + kernel_stack_temp_page_num);
+        WriteRegister(REG_TLB_FLUSH,
+                      (unsigned int) ((i + kernel_stack_temp_page_num) << PAGESHIFT));
     }
-    WriteRegister(REG_TLB_FLUSH, TLB_FLUSH_ALL);
     return _kctxt;
 }
 
@@ -663,7 +693,9 @@ KernelContext *MyKCS(KernelContext *_kctxt, void *_curr_pcb_p, void *_next_pcb_p
            KERNEL_NUMBER_STACK_FRAMES * sizeof(pte_t));    // kernel page table
 
     // 5. Tell the CPU where to find the page table for our new running process.
-    //    Remember to flush the TLB so we dont map to the previous process' frames!
+    //    Remember to flush the TLB so we dont map to the previous process' frames! Only region 1
+    //    and the kernel stack differ between processes, so keep the rest of region 0 (kernel
+    //    text, data, and heap) cached across the switch.
     if (running_old) {
         TracePrintf(1, "[MyKCS] Switching from pid: %d to pid: %d\n\n",
                                 running_old->pid, running_new->pid);
@@ -671,8 +703,9 @@ KernelContext *MyKCS(KernelContext *_kctxt, void *_curr_pcb_p, void *_next_pcb_p
         TracePrintf(1, "[MyKCS] Switching from deleted process to pid: %d\n\n",
                                 running_new->pid);
     } 
-    WriteRegister(REG_PTBR1, (unsigned int) running_new->pt);    // pt address
-    WriteRegister(REG_TLB_FLUSH, TLB_FLUSH_ALL);
+    WriteRegister(REG_PTBR1, (unsigned int) ProcessPTELoad(running_new));    // pt address
+    WriteRegister(REG_TLB_FLUSH, TLB_FLUSH_1);
+    WriteRegister(REG_TLB_FLUSH, TLB_FLUSH_KSTACK);
     return running_new->kctxt;
 }
 
@@ -685,4 +718,48 @@ static void DoIdle(void) {
         TracePrintf(1,"DoIdle 1\n");
         Pause();
     }
-}
\ No newline at end of file
+}
+
+
+/*!
+ * \desc                 Parses the key=value boot flags at the front of the kernel's command line
+ *                       arguments and applies them. Parsing stops at the first argument that is
+ *                       not a key=value pair, which is taken to be the init program. Supported:
+ *
+ *                         sched=rr|mlfq|stride   The scheduling policy to use (default rr)
+ *                         swap=zram|disk|off     Where to swap pages to under memory pressure
+ *                                                (default zram, compressed in memory)
+ *
+ * \param[in] _cmd_args  The command line arguments passed to KernelStart
+ *
+ * \return               A pointer to the first argument that is not a boot flag.
+ */
+static char **KernelParseBootFlags(char **_cmd_args) {
+    // 1. Walk the arguments until we hit one without an '=' (or run out of arguments).
+    char *swap_mode = "zram";
+    while (_cmd_args[0] && strchr(_cmd_args[0], '=')) {
+        char *arg = _cmd_args[0];
+
+        // 2. Apply the flag. Halt on anything we do not recognize rather than silently booting
+        //    with a configuration that the user did not ask for.
+        if (!strncmp(arg, "sched=", 6)) {
+            if (SchedulerSetPolicy(e_scheduler, arg + 6) == ERROR) {
+                TracePrintf(1, "[KernelParseBootFlags] Unknown scheduling policy: %s\n", arg + 6);
+                Halt();
+            }
+        } else if (!strncmp(arg, "swap=", 5)) {
+            swap_mode = arg + 5;
+        } else {
+            TracePrintf(1, "[KernelParseBootFlags] Unknown boot flag: %s\n", arg);
+            Halt();
+        }
+        _cmd_args++;
+    }
+
+    // 3. Set up swapping once we know which mode to use, since it allocates memory up front.
+    if (SwapInit(swap_mode) == ERROR) {
+        TracePrintf(1, "[KernelParseBootFlags] Unknown swap mode: %s\n", swap_mode);
+        Halt();
+    }
+    return _cmd_args;
+}
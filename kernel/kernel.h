@@ -6,6 +6,7 @@
 #include "pipe.h"
 #include "process.h"
 #include "scheduler.h"
+#include "slab.h"
 #include "tty.h"
 
 #define KERNEL_BYTE_SIZE           8
@@ -18,12 +19,14 @@
  *                        declare them in trap.c/h or syscall.c/h
  */
 extern char        *e_frames;
+extern unsigned short *e_frame_refs;
 extern int          e_num_frames;
 extern cvar_list_t *e_cvar_list;
 extern lock_list_t *e_lock_list;
 extern pipe_list_t *e_pipe_list;
 extern pte_t       *e_kernel_pt; // Kernel Page Table
 extern scheduler_t *e_scheduler;
+extern slab_cache_t e_kctxt_cache; // KernelContexts for every process (see KCCopy)
 extern tty_list_t  *e_tty_list;
 extern void        *e_kernel_curr_brk;
 
@@ -47,7 +50,8 @@ int SetKernelBrk(void *_brk);
  *                        we setup the kernel's page table and a dummy "DoIdle" process to run
  *                        when no other processes are available.
  * 
- * \param[in] _cmd_args   Not used for checkpoint 2
+ * \param[in] _cmd_args   Leading key=value boot flags (e.g., sched=stride), followed by the init
+ *                        program and its arguments (defaults to ./user/init)
  * \param[in] _pmem_size  The size of the physical memory availabe to our system (in bytes)
  * \param[in] _uctxt      An initialized usercontext struct for the DoIdle process
  */
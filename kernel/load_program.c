@@ -7,6 +7,7 @@
 
 #include <fcntl.h>
 #include <unistd.h>
+#include <sys/stat.h>
 #include <ykernel.h>
 #include <load_info.h>
 
@@ -15,8 +16,50 @@
  */
 #include <hardware.h>
 #include "frame.h"
+#include "load_program.h"
 #include "process.h"
 #include "pte.h"
+#include "swap.h"
+
+
+/*
+ * Programs are demand paged: LoadProgram only records where each segment lives in the
+ * executable, and a text or data page is read in (or zero-filled, for bss) the first time
+ * the process touches it.
+ *
+ * A program_t is shared by every process running the same executable (identified by its path
+ * plus the file's device, inode, size and modification time, so a rebuilt binary is never
+ * confused with the old one), and by any children they fork. It doubles as a page cache for
+ * text: text pages are read-only, so the first process to touch one loads it and every other
+ * process just maps the same frame. The cache holds its own reference to each text frame, and
+ * the program (and its cached frames) are released when the last process using it goes away.
+ */
+typedef struct program {
+    struct program *next;   // Next program in our list of loaded programs
+    char *name;         // Path the executable was loaded from
+    dev_t dev;          // Identity of the executable file
+    ino_t ino;
+    off_t size;
+    time_t mtime;
+    int   fd;           // The open executable that pages are read from
+    int   refs;         // Number of processes whose region 1 came from this program
+    int  *text_pfns;    // Frame caching each text page, or ERROR if not loaded yet
+    int   text_pg1;     // First region 1 page (and number of pages) of text
+    int   text_npg;
+    long  text_faddr;   // Offset of the text segment in the executable
+    int   data_pg1;     // First region 1 page of data, followed by id_npg pages of
+    int   id_npg;       // initialized data and then ud_npg pages of bss
+    int   ud_npg;
+    long  id_faddr;     // Offset of the initialized data segment in the executable
+    void *id_end;       // Bss spans [id_end, ud_end) and must be zero-filled
+    void *ud_end;
+} program_t;
+
+static program_t *g_programs = NULL;    // Every program with at least one process running it
+
+static program_t *LoadProgramGet(char *_name, int _fd, struct load_info *_li);
+
+
 /*
  *  Load a program into an existing address space.  The program comes from
  *  the Linux file named "name", and its arguments come from the array at
@@ -44,8 +87,8 @@ LoadProgram(char *name, char *args[], pcb_t *proc) {
     int data_pg1;
     int data_npg;
     int stack_npg;
-    long segment_size;
     char *argbuf;
+    program_t *program;
 
     /*
      * Open the executable file
@@ -76,10 +119,12 @@ LoadProgram(char *name, char *args[], pcb_t *proc) {
     data_npg = li.id_npg + li.ud_npg;
     TracePrintf(1, "[LoadProgram] text_pg1: %d\tdata_pg1: %d\tdata_npg: %d\n", text_pg1, data_pg1, data_npg);
 
-    proc->data_end = (void *) ((data_pg1 + data_npg) << PAGESHIFT);
-    proc->data_end += VMEM_1_BASE;
-    proc->brk      = proc->data_end;
-    TracePrintf(1, "[LoadProgram] proc->data_end: %p\n", proc->data_end);
+    /*
+     * The new data_end and brk only go into the pcb once the old region 1 is gone below: a vfork
+     * child still holds its parent's region 1, and with it the parent's brk and data_end.
+     */
+    void *data_end = (void *) ((data_pg1 + data_npg) << PAGESHIFT) + VMEM_1_BASE;
+    TracePrintf(1, "[LoadProgram] data_end: %p\n", data_end);
 
     /*
      *  Figure out how many bytes are needed to hold the arguments on
@@ -171,6 +216,17 @@ LoadProgram(char *name, char *args[], pcb_t *proc) {
         cp2 += strlen(cp2) + 1;
     }
 
+    /*
+     * Find the program in our list of loaded programs (sharing its cached text pages), or
+     * record the segment layout of a new one so that text and data pages can be faulted in
+     * from the executable later on (see LoadProgramFault).
+     */
+    program = LoadProgramGet(name, fd, &li);
+    if (!program) {
+        TracePrintf(1, "[LoadProgram] Failed: unable to set up program struct\n");
+        Halt();
+    }
+
     /*
      * Set up the page tables for the process so that we can read the
      * program into memory.  Get the right number of physical pages
@@ -178,17 +234,27 @@ LoadProgram(char *name, char *args[], pcb_t *proc) {
      */
 
 
+    /*
+     * If the process is running in its parent's region 1 (see SyscallVfork), the arguments are
+     * saved now, so hand that region 1 back to the parent instead of throwing it away.
+     */
+    ProcessVforkReturn(proc);
+
     /* ==>> Throw away the old region 1 virtual address space by
      * ==>> curent process by walking through the R1 page table and,
      * ==>> for every valid page, free the pfn and mark the page invalid.
      */
-    for (int k = 0; k < MAX_PT_LEN; k++) {
-        if (proc->pt[k].valid) {
-            proc->pt[k].valid = 0;
-            FrameClear((int) proc->pt[k].pfn);
-            TracePrintf(1, "[LoadProgram] Clearing frame: %d\n", proc->pt[k].pfn);
-        }
+    for (int k = ProcessPTENext(proc, 0); k != ERROR; k = ProcessPTENext(proc, k + 1)) {
+        int pfn = ProcessPTEGet(proc, k)->pfn;
+        ProcessPTEClear(proc, k);
+        FrameClear(pfn);
+        TracePrintf(1, "[LoadProgram] Clearing frame: %d\n", pfn);
     }
+    SwapRelease(proc);
+    LoadProgramRelease(proc);
+    proc->program  = program;
+    proc->data_end = data_end;
+    proc->brk      = data_end;
 
     /*
      * ==>> Then, build up the new region1.
@@ -197,50 +263,18 @@ LoadProgram(char *name, char *args[], pcb_t *proc) {
 
 
     /*
-     * ==>> First, text. Allocate "li.t_npg" physical pages and map them starting at
-     * ==>> the "text_pg1" page in region 1 address space.
-     * ==>> These pages should be marked valid, with a protection of
-     * ==>> (PROT_READ | PROT_WRITE).
+     * Text and data are no longer mapped up front: every text and data page stays
+     * invalid until the process first touches it, at which point TrapMemory calls
+     * LoadProgramFault to read it in from the executable (or zero-fill it for bss).
+     * Only the stack, which we are about to write the arguments to, is mapped now.
      */
-    TracePrintf(1, "[LoadProgram] Mapping pages for text\n");
-    for (int k = 0; k < li.t_npg; k++) {
-        int pfn = FrameFindAndSet();
-        if (pfn == ERROR) {
-            TracePrintf(1, "[LoadProgram] failed: can't find a free frame.\n");
-            close(fd);
-            return KILL;
-        }
-        PTESet(proc->pt,
-               text_pg1 + k,
-               PROT_READ | PROT_WRITE,
-               pfn);
-        TracePrintf(1, "[LoadProgram] Mapping page: %d to frame: %d\n",
-                    text_pg1 + k,
-                    pfn);
+    int frames[MAX_PT_LEN];
+    if (FrameAllocZeroN(stack_npg, frames) == ERROR) {
+        TracePrintf(1, "[LoadProgram] failed: can't find enough free frames.\n");
+        return KILL;
     }
+    int *pfn = frames;
 
-    /*
-     * ==>> Then, data. Allocate "data_npg" physical pages and map them starting at
-     * ==>> the  "data_pg1" in region 1 address space.
-     * ==>> These pages should be marked valid, with a protection of
-     * ==>> (PROT_READ | PROT_WRITE).
-     */
-    TracePrintf(1, "[LoadProgram] Mapping pages for data\n");
-    for (int k = 0; k < data_npg; k++) {
-        int pfn = FrameFindAndSet();
-        if (pfn == ERROR) {
-            TracePrintf(1, "[LoadProgram] failed: can't find a free frame.\n");
-            close(fd);
-            return KILL;
-        }
-        PTESet(proc->pt,
-               data_pg1 + k,
-               PROT_READ | PROT_WRITE,
-               pfn);
-        TracePrintf(1, "[LoadProgram] Mapping page: %d to frame: %d\n",
-                    data_pg1 + k,
-                    pfn);
-    }
     /*
      * ==>> Then, stack. Allocate "stack_npg" physical pages and map them to the top
      * ==>> of the region 1 virtual address space.
@@ -248,80 +282,26 @@ LoadProgram(char *name, char *args[], pcb_t *proc) {
      * ==>> protection of (PROT_READ | PROT_WRITE).
      */
     TracePrintf(1, "[LoadProgram] Mapping pages for stack\n");
-    for (int k = stack_npg; k > 0; k--) {
-        int pfn = FrameFindAndSet();
-        if (pfn == ERROR) {
-            TracePrintf(1, "[LoadProgram] failed: can't find a free frame.\n");
-            close(fd);
+    for (int k = stack_npg; k > 0; k--, pfn++) {
+        if (ProcessPTESet(proc,
+                          MAX_PT_LEN - k,
+                          PROT_READ | PROT_WRITE,
+                          *pfn) == ERROR) {
+            TracePrintf(1, "[LoadProgram] failed: can't map page: %d\n", MAX_PT_LEN - k);
+            for (; k > 0; k--, pfn++) {
+                FrameClear(*pfn);
+            }
             return KILL;
         }
-        PTESet(proc->pt,
-               MAX_PT_LEN - k,
-               PROT_READ | PROT_WRITE,
-               pfn);
         TracePrintf(1, "[LoadProgram] Mapping page: %d to frame: %d\n",
                     MAX_PT_LEN - k,
-                    pfn);
+                    *pfn);
     }
     /*
      * ==>> (Finally, make sure that there are no stale region1 mappings left in the TLB!)
      */
     WriteRegister(REG_TLB_FLUSH, TLB_FLUSH_1);
 
-    /*
-     * All pages for the new address space are now in the page table.
-     */
-
-    /*
-     * Read the text from the file into memory.
-     */
-    lseek(fd, li.t_faddr, SEEK_SET);
-    segment_size = li.t_npg << PAGESHIFT;
-    if (read(fd, (void *) li.t_vaddr, segment_size) != segment_size) {
-        close(fd);
-        return KILL;   // see ykernel.h
-    }
-
-    /*
-     * Read the data from the file into memory.
-     */
-    lseek(fd, li.id_faddr, 0);
-    segment_size = li.id_npg << PAGESHIFT;
-
-    if (read(fd, (void *) li.id_vaddr, segment_size) != segment_size) {
-        close(fd);
-        return KILL;
-    }
-
-
-    close(fd);            /* we've read it all now */
-
-
-    /*
-     * ==>> Above, you mapped the text pages as writable, so this code could write
-     * ==>> the new text there.
-     *
-     * ==>> But now, you need to change the protections so that the machine can execute
-     * ==>> the text.
-     *
-     * ==>> For each text page in region1, change the protection to (PROT_READ | PROT_EXEC).
-     * ==>> If any of these page table entries is also in the TLB,
-     * ==>> you will need to flush the old mapping.
-     */
-
-    for (int k = 0; k < li.t_npg; k++) {
-        proc->pt[text_pg1 + k].prot = PROT_READ | PROT_EXEC;
-        TracePrintf(1, "[LoadProgram] Changing text page: %d to rx prot\n", text_pg1 + k);
-    }
-    // WriteRegister(REG_TLB_FLUSH, TLB_FLUSH_1);
-    WriteRegister(REG_TLB_FLUSH, TLB_FLUSH_ALL);
-
-
-    /*
-     * Zero out the uninitialized data area
-     */
-    bzero((caddr_t) li.id_end, li.ud_end - li.id_end);
-
     /*
      * Set the entry point in the process's UserContext
      */
@@ -353,4 +333,256 @@ LoadProgram(char *name, char *args[], pcb_t *proc) {
     *cpp++ = NULL;            /* a NULL pointer for an empty envp */
 
     return 0;
-}
\ No newline at end of file
+}
+
+
+/*!
+ * \desc                 Checks whether an invalid region 1 page belongs to the text or data
+ *                       (including bss) of the program the process is running, i.e., whether
+ *                       it can be faulted in with LoadProgramFault.
+ *
+ * \param[in] _proc      The pcb for the process
+ * \param[in] _page_num  The region 1 page number
+ *
+ * \return               1 if the page can be demand loaded, 0 otherwise.
+ */
+int LoadProgramHasPage(pcb_t *_proc, int _page_num) {
+    // 1. Check arguments. Processes without a program (e.g., idle) have nothing to load.
+    if (!_proc || !_proc->program || _page_num < 0 || _page_num >= MAX_PT_LEN) {
+        return 0;
+    }
+    if (ProcessPTEGet(_proc, _page_num) || SwapIsSwapped(_proc, _page_num)) {
+        return 0;
+    }
+
+    // 2. Check if the page falls within the text or data segments of the program.
+    program_t *program = _proc->program;
+    if (_page_num >= program->text_pg1 &&
+        _page_num <  program->text_pg1 + program->text_npg) {
+        return 1;
+    }
+    if (_page_num >= program->data_pg1 &&
+        _page_num <  program->data_pg1 + program->id_npg + program->ud_npg) {
+        return 1;
+    }
+    return 0;
+}
+
+
+/*!
+ * \desc                 Demand loads a text or data page of the current running process: maps a
+ *                       free frame to the page, then reads the page's contents in from the
+ *                       executable (zero-filling any part of it that is bss). Text pages end up
+ *                       read/exec and data pages read/write.
+ *
+ * \param[in] _proc      The pcb for the current running process
+ * \param[in] _page_num  The region 1 page number (see LoadProgramHasPage)
+ *
+ * \return               0 on success, ERROR otherwise.
+ */
+int LoadProgramFault(pcb_t *_proc, int _page_num) {
+    // 1. Check arguments. Return error if invalid.
+    if (!LoadProgramHasPage(_proc, _page_num)) {
+        TracePrintf(1, "[LoadProgramFault] Page %d is not a program page\n", _page_num);
+        return ERROR;
+    }
+
+    // 2. If this is a text page that another process running the program has already loaded,
+    //    simply share its frame.
+    program_t *program = _proc->program;
+    int  text = _page_num < program->text_pg1 + program->text_npg;
+    if (text && program->text_pfns[_page_num - program->text_pg1] != ERROR) {
+        int pfn = program->text_pfns[_page_num - program->text_pg1];
+        if (ProcessPTESet(_proc, _page_num, PROT_READ | PROT_EXEC, pfn) == ERROR) {
+            TracePrintf(1, "[LoadProgramFault] Failed to map page: %d\n", _page_num);
+            return ERROR;
+        }
+        FrameRef(pfn);
+        TracePrintf(1, "[LoadProgramFault] Sharing page: %d frame: %d\n", _page_num, pfn);
+        return 0;
+    }
+
+    // 3. Figure out where in the executable the page comes from. Pages past the initialized
+    //    data are bss and have no file contents at all.
+    long faddr;
+    int  in_file;
+    if (text) {
+        faddr   = program->text_faddr + ((long) (_page_num - program->text_pg1) << PAGESHIFT);
+        in_file = 1;
+    } else {
+        faddr   = program->id_faddr   + ((long) (_page_num - program->data_pg1) << PAGESHIFT);
+        in_file = _page_num < program->data_pg1 + program->id_npg;
+    }
+
+    // 4. Map a free frame to the page as writable so that we can fill it in. Pages that are
+    //    entirely bss get a frame that is already zeroed (usually by idle, ahead of time).
+    int pfn = in_file ? FrameFindAndSet() : FrameAllocZero();
+    if (pfn == ERROR) {
+        TracePrintf(1, "[LoadProgramFault] Failed to find a free frame\n");
+        return ERROR;
+    }
+    if (ProcessPTESet(_proc, _page_num, PROT_READ | PROT_WRITE, pfn) == ERROR) {
+        TracePrintf(1, "[LoadProgramFault] Failed to map page: %d\n", _page_num);
+        FrameClear(pfn);
+        return ERROR;
+    }
+    TracePrintf(1, "[LoadProgramFault] Loading page: %d into frame: %d\n", _page_num, pfn);
+
+    // 5. Read the page in from the executable (a page that is entirely bss is already zeroed).
+    //    Then zero out whatever part of the page overlaps the bss (the last initialized data
+    //    page may share a page with the start of bss).
+    void *page_addr = (void *) (VMEM_1_BASE + (_page_num << PAGESHIFT));
+    if (in_file) {
+        lseek(program->fd, faddr, SEEK_SET);
+        if (read(program->fd, page_addr, PAGESIZE) != PAGESIZE) {
+            TracePrintf(1, "[LoadProgramFault] Failed to read page: %d\n", _page_num);
+            ProcessPTEClear(_proc, _page_num);
+            WriteRegister(REG_TLB_FLUSH, (unsigned int) page_addr);
+            FrameClear(pfn);
+            return ERROR;
+        }
+    }
+    if (!text) {
+        void *start = page_addr;
+        void *end   = page_addr + PAGESIZE;
+        if (start < program->id_end) { start = program->id_end; }
+        if (end   > program->ud_end) { end   = program->ud_end; }
+        if (start < end) {
+            bzero(start, end - start);
+        }
+    }
+
+    // 6. Text pages should be executable but not writable. Flush the writable entry we just used.
+    //    Then add the frame to the program's text cache for other processes to share.
+    if (text) {
+        ProcessPTEUpdate(_proc, _page_num, PROT_READ | PROT_EXEC, pfn);
+        WriteRegister(REG_TLB_FLUSH, (unsigned int) page_addr);
+        program->text_pfns[_page_num - program->text_pg1] = pfn;
+        FrameRef(pfn);
+    }
+    return 0;
+}
+
+
+/*!
+ * \desc                 Lets a forked child demand load the pages of its parent's program that
+ *                       the parent has not touched yet.
+ *
+ * \param[in] _parent    The pcb of the forking process
+ * \param[in] _child     The pcb of its new child
+ */
+void LoadProgramShare(pcb_t *_parent, pcb_t *_child) {
+    if (!_parent || !_child || !_parent->program) {
+        return;
+    }
+    _child->program = _parent->program;
+    _child->program->refs++;
+}
+
+
+/*!
+ * \desc                 Drops the process' reference to its program (e.g., on exec or exit),
+ *                       closing the executable once nobody can fault pages in from it anymore.
+ *
+ * \param[in] _proc      The pcb for the process
+ */
+void LoadProgramRelease(pcb_t *_proc) {
+    if (!_proc || !_proc->program) {
+        return;
+    }
+    program_t *program = _proc->program;
+    _proc->program = NULL;
+    if (--program->refs > 0) {
+        return;
+    }
+
+    // Nobody is running the program anymore: remove it from our list of loaded programs and
+    // drop the text cache's references to its frames.
+    program_t **prev = &g_programs;
+    while (*prev != program) {
+        prev = &(*prev)->next;
+    }
+    *prev = program->next;
+    for (int i = 0; i < program->text_npg; i++) {
+        if (program->text_pfns[i] != ERROR) {
+            FrameClear(program->text_pfns[i]);
+        }
+    }
+    close(program->fd);
+    free(program->text_pfns);
+    free(program->name);
+    free(program);
+}
+
+
+/*!
+ * \desc                 Looks up the program for an executable that is already open. If another
+ *                       process is running the same executable (same path and same file), that
+ *                       program is shared and _fd is closed. Otherwise, a new program is created
+ *                       from the load info and takes ownership of _fd.
+ *
+ * \param[in] _name      The path of the executable
+ * \param[in] _fd        The open executable
+ * \param[in] _li        The executable's load info
+ *
+ * \return               The program with a reference held for the caller, NULL otherwise.
+ */
+static program_t *LoadProgramGet(char *_name, int _fd, struct load_info *_li) {
+    // 1. Identify the file itself, so that a binary that has been rebuilt in place is not
+    //    mistaken for the one that the existing processes are running.
+    struct stat st;
+    if (fstat(_fd, &st) < 0) {
+        TracePrintf(1, "[LoadProgramGet] Unable to stat '%s'\n", _name);
+        return NULL;
+    }
+
+    // 2. If some process is already running this executable, share its program.
+    for (program_t *program = g_programs; program; program = program->next) {
+        if (program->dev  == st.st_dev  && program->ino   == st.st_ino   &&
+            program->size == st.st_size && program->mtime == st.st_mtime &&
+            !strcmp(program->name, _name)) {
+            TracePrintf(1, "[LoadProgramGet] Sharing loaded program '%s'\n", _name);
+            close(_fd);
+            program->refs++;
+            return program;
+        }
+    }
+
+    // 3. Otherwise, record the new program's identity and segment layout.
+    program_t *program = (program_t *) malloc(sizeof(program_t));
+    if (!program) {
+        return NULL;
+    }
+    program->name      = (char *) malloc(strlen(_name) + 1);
+    program->text_pfns = (int *)  malloc((_li->t_npg + 1) * sizeof(int));
+    if (!program->name || !program->text_pfns) {
+        free(program->name);
+        free(program->text_pfns);
+        free(program);
+        return NULL;
+    }
+    strcpy(program->name, _name);
+    for (int i = 0; i < _li->t_npg; i++) {
+        program->text_pfns[i] = ERROR;
+    }
+    program->dev        = st.st_dev;
+    program->ino        = st.st_ino;
+    program->size       = st.st_size;
+    program->mtime      = st.st_mtime;
+    program->fd         = _fd;
+    program->refs       = 1;
+    program->text_pg1   = (_li->t_vaddr  - VMEM_1_BASE) >> PAGESHIFT;
+    program->text_npg   = _li->t_npg;
+    program->text_faddr = _li->t_faddr;
+    program->data_pg1   = (_li->id_vaddr - VMEM_1_BASE) >> PAGESHIFT;
+    program->id_npg     = _li->id_npg;
+    program->ud_npg     = _li->ud_npg;
+    program->id_faddr   = _li->id_faddr;
+    program->id_end     = (void *) _li->id_end;
+    program->ud_end     = (void *) _li->ud_end;
+
+    // 4. Add it to our list of loaded programs.
+    program->next = g_programs;
+    g_programs    = program;
+    return program;
+}
@@ -4,6 +4,10 @@
 #include "process.h"
 
 
-int LoadProgram(char *name, char *args[], pcb_t *proc);
+int  LoadProgram(char *name, char *args[], pcb_t *proc);
+int  LoadProgramFault(pcb_t *_proc, int _page_num);
+int  LoadProgramHasPage(pcb_t *_proc, int _page_num);
+void LoadProgramRelease(pcb_t *_proc);
+void LoadProgramShare(pcb_t *_parent, pcb_t *_child);
 
 #endif // YALNIX_FRAMEWORK_LOAD_PROGRAM_H
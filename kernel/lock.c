@@ -14,6 +14,7 @@
 typedef struct lock {
     int lock_id;
     int lock_pid;
+    pcb_queue_t waiters;        // Processes blocked waiting to acquire the lock (FIFO)
     struct lock *next;
     struct lock *prev;
 } lock_t;
@@ -24,6 +25,12 @@ typedef struct lock_list {
 } lock_list_t;
 
 
+/*
+ * Local Global Variable Definitions
+ */
+static slab_cache_t g_lock_cache = SLAB_CACHE_INIT("lock_t", sizeof(lock_t), NULL);
+
+
 /*
  * Local Function Definitions
  */
@@ -68,7 +75,7 @@ int LockListDelete(lock_list_t *_ll) {
     lock_t *lock = _ll->start;
     while (lock) {
         lock_t *next = lock->next;
-        free(lock);
+        SlabFree(&g_lock_cache, lock);
         lock = next;
     }
     free(_ll);
@@ -103,10 +110,10 @@ int LockInit(lock_list_t *_ll, int *_lock_id, int check_addr_flag) {
     //    (i.e., in valid pages) with write permissions so we can write the lock id there.
     int ret;
     if (check_addr_flag) {
-        ret = PTECheckAddress(running_old->pt,
-                        _lock_id,
-                        sizeof(int),
-                        PROT_WRITE);
+        ret = ProcessCheckAddress(running_old,
+                            _lock_id,
+                            sizeof(int),
+                            PROT_WRITE);
         if (ret < 0) {
             TracePrintf(1, "[LockInit] _lock_id pointer is not within valid address space\n");
             return ERROR;
@@ -114,7 +121,7 @@ int LockInit(lock_list_t *_ll, int *_lock_id, int check_addr_flag) {
     }
 
     // 4. Allocate space for a new lock struct
-    lock_t *lock = (lock_t *) malloc(sizeof(lock_t));
+    lock_t *lock = (lock_t *) SlabAlloc(&g_lock_cache);
     if (!lock) {
         TracePrintf(1, "[LockInit] Error mallocing space for lock struct\n");
         return ERROR;
@@ -124,11 +131,13 @@ int LockInit(lock_list_t *_ll, int *_lock_id, int check_addr_flag) {
     lock->lock_id   = LockIDFindAndSet();
     if (lock->lock_id == ERROR) {
         TracePrintf(1, "[LockInit] Failed to find a valid lock_id.\n");
-        free(lock);
+        SlabFree(&g_lock_cache, lock);
         return ERROR;
 
     }
     lock->lock_pid = 0;
+    lock->waiters.start = NULL;
+    lock->waiters.end   = NULL;
     lock->next      = NULL;
     lock->prev      = NULL;
 
@@ -139,7 +148,7 @@ int LockInit(lock_list_t *_ll, int *_lock_id, int check_addr_flag) {
     // 7. Add the new lock id to the process's resource list
     if (list_append(running_old->res_list, lock->lock_id, NULL) == ERROR) {
         LockRemove(_ll, lock->lock_id);
-        free(lock);
+        SlabFree(&g_lock_cache, lock);
         return ERROR;
     }
     return 0;
@@ -189,7 +198,6 @@ int LockAcquire(lock_list_t *_ll, UserContext *_uctxt, int _lock_id) {
         return 0;
     }
 
-    running_old->lock_id = _lock_id;
     memcpy(&running_old->uctxt, _uctxt, sizeof(UserContext));
 
     // 5. If a process already has the lock, then add the current process to the lock
@@ -199,7 +207,7 @@ int LockAcquire(lock_list_t *_ll, UserContext *_uctxt, int _lock_id) {
     while (lock->lock_pid != 0) {
         TracePrintf(1, "[LockAcquire] _lock_id: %d in use by process: %d. Blocking process: %d\n",
                     _lock_id, lock->lock_pid, running_old->pid);
-        SchedulerAddLock(e_scheduler, running_old);
+        SchedulerAddLock(e_scheduler, &lock->waiters, running_old);
         KCSwitch(_uctxt, running_old);
 
         // Check if it's a spurious wakeup, i.e, the lock was acquired by other process again
@@ -262,7 +270,7 @@ int LockRelease(lock_list_t *_ll, int _lock_id) {
 
     // 6. Mark the current lock as free and unblock the next process (if any) waiting on the lock
     lock->lock_pid = 0;
-    SchedulerUpdateLock(e_scheduler, _lock_id);
+    SchedulerUpdateLock(e_scheduler, &lock->waiters);
     return 0;
 }
 
@@ -285,6 +293,14 @@ int LockReclaim(lock_list_t *_ll, int _lock_id) {
         TracePrintf(1, "[LockReclaim] Invalid lock id %d.\n", _lock_id);
         return ERROR;
     }
+    // Refuse to free the lock while processes are still waiting on it, since their pcbs are
+    // linked into the lock's wait queue.
+    lock_t *lock = LockGet(_ll, _lock_id);
+    if (lock && lock->waiters.start) {
+        TracePrintf(1, "[LockReclaim] Lock %d still has waiting processes\n", _lock_id);
+        return ERROR;
+    }
+
     // Remove the lock from the list and free its resources
     if (LockRemove(_ll, _lock_id) == ERROR) {
         TracePrintf(1, "[LockReclaim] Failed to remove lock %d\n", _lock_id);
@@ -397,7 +413,7 @@ static int LockRemove(lock_list_t *_ll, int _lock_id) {
         if (_ll->start) {
             _ll->start->prev = NULL;
         }
-        free(lock);
+        SlabFree(&g_lock_cache, lock);
         return 0;
     }
 
@@ -406,7 +422,7 @@ static int LockRemove(lock_list_t *_ll, int _lock_id) {
     if (lock->lock_id == _lock_id) {
         _ll->end       = lock->prev;
         _ll->end->next = NULL;
-        free(lock);
+        SlabFree(&g_lock_cache, lock);
         return 0;
     }
 
@@ -418,7 +434,7 @@ static int LockRemove(lock_list_t *_ll, int _lock_id) {
         if (lock->lock_id == _lock_id) {
             lock->prev->next = lock->next;
             lock->next->prev = lock->prev;
-            free(lock);
+            SlabFree(&g_lock_cache, lock);
             return 0;
         }
         lock = lock->next;
@@ -0,0 +1,185 @@
+#include <hardware.h>
+#include <ykernel.h>
+
+#include "frame.h"
+#include "kernel.h"
+#include "merge.h"
+#include "process.h"
+#include "pte.h"
+#include "scheduler.h"
+#include "swap.h"
+
+
+/*
+ * Internal struct definitions
+ */
+typedef struct merge_entry {
+    unsigned int hash;      // Hash of the frame's contents when it was scanned
+    int          pfn;       // Frame that was scanned (ERROR if the entry is empty)
+} merge_entry_t;
+
+
+/*
+ * Local Global Variable Definitions
+ */
+static merge_entry_t g_table[MERGE_TABLE_SIZE];
+static int           g_table_ready   = 0;
+static int           g_scan_hand     = 0;
+static int           g_num_scanned   = 0;
+static int           g_num_merged    = 0;
+static int           g_num_unmerged  = 0;
+
+
+/*
+ * Local Function Definitions
+ */
+static int   MergeCanProtect(pcb_t *_process, int _page_num);
+static void *MergeMap(int _slot, int _pfn);
+static void  MergeScan(int _pfn);
+static int   MergeTarget(int _pfn);
+static void  MergeUnmap(int _slot);
+
+
+void MergeIdle() {
+    // 1. The table starts out empty (frame 0 is a perfectly good frame number).
+    if (!g_table_ready) {
+        for (int i = 0; i < MERGE_TABLE_SIZE; i++) {
+            g_table[i].pfn = ERROR;
+        }
+        g_table_ready = 1;
+    }
+
+    // 2. Scan the next few frames. Only a few per tick, since hashing and comparing pages is not
+    //    cheap and idle also has frames to zero.
+    for (int i = 0; i < MERGE_PAGES_PER_TICK; i++) {
+        int pfn     = g_scan_hand;
+        g_scan_hand = (g_scan_hand + 1) % e_num_frames;
+        MergeScan(pfn);
+    }
+}
+
+
+void MergePrintStats() {
+    TracePrintf(1, "[MergePrintStats] scanned: %d merged: %d unmerged: %d\n",
+                   g_num_scanned, g_num_merged, g_num_unmerged);
+}
+
+
+void MergeUnmerged() {
+    g_num_unmerged++;
+}
+
+
+static int MergeCanProtect(pcb_t *_process, int _page_num) {
+    // 1. We may only take write access away from a page if its process was preempted in user
+    //    mode or is sleeping in Delay: a process blocked elsewhere in the kernel may be about to
+    //    write into its pages directly (e.g., to finish a TtyRead), having already broken
+    //    copy-on-write sharing for them. Preempted processes are ready to run, so while idle runs
+    //    the sleepers are the only candidates. Idle always counts as running here, since it is the
+    //    one running the scanner.
+    if (!_process || _process == SchedulerGetIdle(e_scheduler) || !_process->preempted) {
+        return 0;
+    }
+    return 1;
+}
+
+
+static void *MergeMap(int _slot, int _pfn) {
+    // 1. Temporarily map the frame to one of the two pages right below the kernel stack (making
+    //    sure the kernel heap has not grown into it).
+    int   temp_page_num  = (KERNEL_STACK_BASE >> PAGESHIFT) - 1 - _slot;
+    void *temp_page_addr = (void *) (temp_page_num << PAGESHIFT);
+    if (temp_page_addr < e_kernel_curr_brk) {
+        TracePrintf(1, "[MergeMap] Kernel heap overlaps the temporary page\n");
+        return NULL;
+    }
+    PTESet(e_kernel_pt, temp_page_num, PROT_READ, _pfn);
+    return temp_page_addr;
+}
+
+
+static void MergeScan(int _pfn) {
+    // 1. Only private pages whose write access we can take away are candidates.
+    int    page_num;
+    pcb_t *process = SwapGetOwner(_pfn, &page_num);
+    if (FrameRefCount(_pfn) != 1 || !MergeCanProtect(process, page_num)) {
+        return;
+    }
+    g_num_scanned++;
+
+    // 2. Hash the page's contents and look it up in the table. If the page there is not the
+    //    same (or is no longer something we can merge into), replace it with this one.
+    unsigned int *words = (unsigned int *) MergeMap(0, _pfn);
+    if (!words) {
+        return;
+    }
+    unsigned int hash = 2166136261u;
+    for (int i = 0; i < PAGESIZE / (int) sizeof(unsigned int); i++) {
+        hash = (hash ^ words[i]) * 16777619u;
+    }
+    merge_entry_t *entry = &g_table[hash % MERGE_TABLE_SIZE];
+    int   target = entry->hash == hash && entry->pfn != _pfn ? MergeTarget(entry->pfn) : ERROR;
+    void *other  = target != ERROR ? MergeMap(1, target) : NULL;
+    int   same   = other && !memcmp(words, other, PAGESIZE);
+    if (other) {
+        MergeUnmap(1);
+    }
+    MergeUnmap(0);
+    if (!same) {
+        entry->hash = hash;
+        entry->pfn  = _pfn;
+        return;
+    }
+
+    // 3. The pages are identical. If the target frame is still private to its page, make that
+    //    page read-only and copy-on-write first (shared frames are always mapped read-only).
+    if (FrameRefCount(target) == 1) {
+        int    target_page;
+        pcb_t *target_process = SwapGetOwner(target, &target_page);
+        pte_t *pte            = ProcessPTEGet(target_process, target_page);
+        if ((pte->prot & PROT_WRITE) || ProcessPTEGetCOW(target_process, target_page)) {
+            ProcessPTEUpdate(target_process, target_page, pte->prot & ~PROT_WRITE, target);
+            ProcessPTESetCOW(target_process, target_page, MERGE_COW);
+        }
+    }
+
+    // 4. Point our page at the target frame the same way, and free our own frame. Neither process
+    //    is running, so their TLB entries are flushed when they are switched back in.
+    pte_t *pte  = ProcessPTEGet(process, page_num);
+    int    prot = pte->prot;
+    FrameRef(target);
+    ProcessPTEUpdate(process, page_num, prot & ~PROT_WRITE, target);
+    if ((prot & PROT_WRITE) || ProcessPTEGetCOW(process, page_num)) {
+        ProcessPTESetCOW(process, page_num, MERGE_COW);
+    }
+    FrameClear(_pfn);
+    g_num_merged++;
+    TracePrintf(1, "[MergeScan] Merged pid: %d page: %d frame: %d into frame: %d\n",
+                   process->pid, page_num, _pfn, target);
+    MergePrintStats();
+}
+
+
+static int MergeTarget(int _pfn) {
+    // 1. A table entry may be long stale, so check that its frame is still a user page we can
+    //    merge into: either already shared (and so read-only everywhere), or private to a page
+    //    that we can make read-only.
+    int refs = FrameRefCount(_pfn);
+    if (refs > 1) {
+        return _pfn;
+    }
+    int    page_num;
+    pcb_t *process = SwapGetOwner(_pfn, &page_num);
+    if (refs == 1 && MergeCanProtect(process, page_num)) {
+        return _pfn;
+    }
+    return ERROR;
+}
+
+
+static void MergeUnmap(int _slot) {
+    int   temp_page_num  = (KERNEL_STACK_BASE >> PAGESHIFT) - 1 - _slot;
+    void *temp_page_addr = (void *) (temp_page_num << PAGESHIFT);
+    PTEClear(e_kernel_pt, temp_page_num);
+    WriteRegister(REG_TLB_FLUSH, (unsigned int) temp_page_addr);
+}
@@ -0,0 +1,34 @@
+#ifndef __MERGE_H
+#define __MERGE_H
+#include <hardware.h>
+#include "process.h"
+
+// Same-page merging. While idle runs, the scanner walks physical memory looking at up to
+// MERGE_PAGES_PER_TICK frames per clock tick (its rate limit). Each private user page it finds
+// is hashed into a table of MERGE_TABLE_SIZE recently seen pages, and if it is byte-identical
+// to the page already there, both are pointed at one read-only frame. Merged pages have their
+// copy-on-write flag set to MERGE_COW, so a write to one copies it back out (ProcessCopyOnWrite).
+#define MERGE_PAGES_PER_TICK  16
+#define MERGE_TABLE_SIZE      256
+#define MERGE_COW             2
+
+
+/*!
+ * \desc    Scans the next MERGE_PAGES_PER_TICK frames, merging any duplicate pages it finds.
+ *          Called by TrapClock when it interrupts idle.
+ */
+void MergeIdle(void);
+
+
+/*!
+ * \desc    Prints the merging counters with TracePrintf: pages scanned, merged and unmerged.
+ */
+void MergePrintStats(void);
+
+
+/*!
+ * \desc    Counts a merged page that was written to and given its own copy again. Called by
+ *          ProcessCopyOnWrite.
+ */
+void MergeUnmerged(void);
+#endif // __MERGE_H
@@ -12,13 +12,21 @@
  * Internal struct definitions
  */
 typedef struct pipe {
-    char  buf[PIPE_BUFFER_LEN];
+    char **pages;               // PAGESIZE heap chunks backing the ring if the pipe is larger than
+                                // PIPE_BUFFER_LEN (each entry NULL until needed), else NULL
+    int   buf_size;             // Capacity of the ring
+    int   buf_head;
     int   buf_len;
     int   pipe_id;
-    int   read_pid;
-    int   write_pid;
+    int   read_waking;          // Whether the first reader in line was woken and has not run yet
+    int   writing;              // Whether a writer has the turn (until all its bytes are written)
+    pcb_queue_t readers;        // Processes waiting for data to read, in arrival order
+    pcb_queue_t writers;        // Processes waiting for their turn to write, in arrival order
+    pcb_queue_t space;          // The writer with the turn, while it waits for room in the pipe
     struct pipe *next;
     struct pipe *prev;
+    char  buf[];                // Ring buffer of a small pipe: buf_len bytes starting at buf_head
+                                // (wrapping around). Large pipes are allocated without it.
 } pipe_t;
 
 typedef struct pipe_list {
@@ -27,11 +35,28 @@ typedef struct pipe_list {
 } pipe_list_t;
 
 
+/*
+ * Local Global Variable Definitions
+ */
+static slab_cache_t g_pipe_cache       = SLAB_CACHE_INIT("pipe_t", sizeof(pipe_t) + PIPE_BUFFER_LEN,
+                                                          NULL);
+static slab_cache_t g_large_pipe_cache = SLAB_CACHE_INIT("pipe_t (large)", sizeof(pipe_t), NULL);
+
+
 /*
  * Local Function Definitions
  */
 static int     PipeAdd(pipe_list_t *_pl, pipe_t *_pipe);
+static void    PipeCopyIn(pipe_t *_pipe, void *_buf, int _len);
+static void    PipeCopyOut(pipe_t *_pipe, void *_buf, int _len);
+static void    PipeFree(pipe_t *_pipe);
+static void    PipeFreePages(pipe_t *_pipe);
 static pipe_t *PipeGet(pipe_list_t *_pl, int _pipe_id);
+static int     PipeHandOff(pipe_t *_pipe, pcb_t *_writer);
+static int     PipePageIsLive(pipe_t *_pipe, int _page);
+static char   *PipeRange(pipe_t *_pipe, int _pos, int _len, int *_chunk);
+static int     PipeReserve(pipe_t *_pipe, int _len);
+static void    PipeWakeReader(pipe_t *_pipe);
 static int     PipeRemove(pipe_list_t *_pl, int _pipe_id);
 
 
@@ -71,7 +96,7 @@ int PipeListDelete(pipe_list_t *_pl) {
     pipe_t *pipe = _pl->start;
     while (pipe) {
         pipe_t *next = pipe->next;
-        free(pipe);
+        PipeFree(pipe);
         pipe = next;
     }
     free(_pl);
@@ -88,48 +113,95 @@ int PipeListDelete(pipe_list_t *_pl) {
  * \return               0 on success, ERROR otherwise
  */
 int PipeInit(pipe_list_t *_pl, int *_pipe_id) {
+    return PipeInitSized(_pl, _pipe_id, PIPE_BUFFER_LEN);
+}
+
+
+/*!
+ * \desc                 Creates a new pipe that holds up to _size bytes and saves the id at the
+ *                       caller specified address. Pipes of up to PIPE_BUFFER_LEN bytes keep their
+ *                       bytes inside the pipe struct. Larger pipes are backed by PAGESIZE chunks
+ *                       of the kernel heap that are only allocated as bytes are written to them,
+ *                       and freed again once readers have drained them, so an idle large pipe
+ *                       costs next to nothing. Freed chunks go back to the kernel heap for other
+ *                       kernel allocations to reuse (the kernel brk never shrinks, so no frames
+ *                       are released).
+ *
+ * \param[in]  _pl       An initialized pipe_list_t struct
+ * \param[out] _pipe_id  The address where the newly created pipe's id should be stored
+ * \param[in]  _size     The capacity of the pipe in bytes (at most PIPE_MAX_LEN). Sizes smaller
+ *                       than PIPE_BUFFER_LEN are rounded up to it.
+ * 
+ * \return               0 on success, ERROR otherwise
+ */
+int PipeInitSized(pipe_list_t *_pl, int *_pipe_id, int _size) {
     // 1. Check arguments. Return ERROR if invalid.
     if (!_pl || !_pipe_id) {
-        TracePrintf(1, "[PipeInit] One or more invalid arguments\n");
+        TracePrintf(1, "[PipeInitSized] One or more invalid arguments\n");
+        return ERROR;
+    }
+    if (_size < 1 || _size > PIPE_MAX_LEN) {
+        TracePrintf(1, "[PipeInitSized] Invalid pipe size: %d\n", _size);
         return ERROR;
     }
 
     // 2. Get the pcb for the current running process.
     pcb_t *running_old = SchedulerGetRunning(e_scheduler);
     if (!running_old) {
-        TracePrintf(1, "[PipeInit] e_scheduler returned no running process\n");
+        TracePrintf(1, "[PipeInitSized] e_scheduler returned no running process\n");
         Halt();
     }
 
     // 3. Check that the user output variable for the pipe id is within valid memory space.
     //    Specifically, every byte of the int should be in the process' region 1 memory space
     //    (i.e., in valid pages) with write permissions so we can write the pipe id there.
-    int ret = PTECheckAddress(running_old->pt,
-                              _pipe_id,
-                              sizeof(int),
-                              PROT_WRITE);
+    int ret = ProcessCheckAddress(running_old,
+                                  _pipe_id,
+                                  sizeof(int),
+                                  PROT_WRITE);
     if (ret < 0) {
-        TracePrintf(1, "[PipeRead] _pipe_id pointer is not within valid address space\n");
+        TracePrintf(1, "[PipeInitSized] _pipe_id pointer is not within valid address space\n");
         return ERROR;
     }
 
-    // 4. Allocate space for a new pipe struct
-    pipe_t *pipe = (pipe_t *) malloc(sizeof(pipe_t));
+    // 4. Allocate space for a new pipe struct. Only a small pipe has its ring buffer inside it.
+    int     size  = _size < PIPE_BUFFER_LEN ? PIPE_BUFFER_LEN : _size;
+    int     large = size > PIPE_BUFFER_LEN;
+    pipe_t *pipe  = (pipe_t *) SlabAlloc(large ? &g_large_pipe_cache : &g_pipe_cache);
     if (!pipe) {
-        TracePrintf(1, "[PipeInit] Error mallocing space for pipe struct\n");
+        TracePrintf(1, "[PipeInitSized] Error mallocing space for pipe struct\n");
         return ERROR;
     }
 
-    // 5. Initialize internal members and increment the total number of pipes
+    // 5. Initialize internal members and increment the total number of pipes. A large pipe
+    //    only gets its (empty) table of pages for now.
+    pipe->pages     = NULL;
+    pipe->buf_size  = size;
+    pipe->buf_head  = 0;
     pipe->buf_len   = 0;
+    if (large) {
+        int num_pages = (pipe->buf_size + PAGESIZE - 1) / PAGESIZE;
+        pipe->pages   = (char **) calloc(num_pages, sizeof(char *));
+        if (!pipe->pages) {
+            TracePrintf(1, "[PipeInitSized] Error allocating the page table for the pipe\n");
+            SlabFree(&g_large_pipe_cache, pipe);
+            return ERROR;
+        }
+    }
     pipe->pipe_id   = PipeIDFindAndSet();
     if (pipe->pipe_id == ERROR) {
-        TracePrintf(1, "[PipeInit] Failed to find a valid pipe_id.\n");
-        free(pipe);
+        TracePrintf(1, "[PipeInitSized] Failed to find a valid pipe_id.\n");
+        PipeFree(pipe);
         return ERROR;
     }
-    pipe->read_pid  = 0;
-    pipe->write_pid = 0;
+    pipe->read_waking = 0;
+    pipe->writing     = 0;
+    pipe->readers.start = NULL;
+    pipe->readers.end   = NULL;
+    pipe->writers.start = NULL;
+    pipe->writers.end   = NULL;
+    pipe->space.start   = NULL;
+    pipe->space.end     = NULL;
     pipe->next      = NULL;
     pipe->prev      = NULL;
 
@@ -141,7 +213,6 @@ int PipeInit(pipe_list_t *_pl, int *_pipe_id) {
     ret = list_append(running_old->res_list, pipe->pipe_id, NULL);
     if (ret == ERROR) {
         PipeRemove(_pl, pipe->pipe_id);
-        free(pipe);
         return ERROR;
     }
 
@@ -165,6 +236,15 @@ int PipeReclaim(pipe_list_t *_pl, int _pipe_id) {
         TracePrintf(1, "[PipeReclaim] Error in trying to reclaim an invalid pipe id.\n");
         return ERROR;
     }
+    // Refuse to free the pipe while processes are still waiting on it (or have been woken to
+    // use it and have not run yet), since their pcbs are linked into the pipe's wait queues.
+    pipe_t *pipe = PipeGet(_pl, _pipe_id);
+    if (pipe && (pipe->readers.start || pipe->writers.start || pipe->space.start ||
+                 pipe->read_waking   || pipe->writing)) {
+        TracePrintf(1, "[PipeReclaim] Pipe %d still has waiting processes\n", _pipe_id);
+        return ERROR;
+    }
+
     // Remove the pipe from the list and free its resources
     if (PipeRemove(_pl, _pipe_id) == ERROR) {
         helper_abort("[PipeReclaim] error removing a pipe.\n");
@@ -182,9 +262,10 @@ int PipeReclaim(pipe_list_t *_pl, int _pipe_id) {
  * \desc                 Reads from the pipe and stores the bytes in the caller's output buffer.
  *                       The caller is not guaranteed to get _buf_len bytes back, however, if
  *                       there are not enough bytes in the pipe---we simply return whatever is
- *                       in the pipe at the time. If there are no bytes or another process is
- *                       currently reading from the pipe, however, the caller is blocked until
- *                       the pipe is free and/or has bytes to read.
+ *                       in the pipe at the time. If there are no bytes or other readers are
+ *                       already waiting on the pipe, however, the caller is blocked until it
+ *                       is its turn and the pipe has bytes to read. Readers are served in the
+ *                       order they arrive.
  * 
  * \param[in]  _pl       An initialized pipe_list_t struct
  * \param[in]  _uctxt    The UserContext for the current running process
@@ -223,10 +304,10 @@ int PipeRead(pipe_list_t *_pl, UserContext *_uctxt, int _pipe_id, void *_buf, in
     // 3. Check that the user output read buffer is within valid memory space. Specifically, every
     //    byte of the buffer should be in the process' region 1 memory space (i.e., in valid pages)
     //    and have write permissions since we are supposed to write the pipe data to it.
-    int ret = PTECheckAddress(running_old->pt,
-                              _buf,
-                              _buf_len,
-                              PROT_WRITE);
+    int ret = ProcessCheckAddress(running_old,
+                                  _buf,
+                                  _buf_len,
+                                  PROT_WRITE);
     if (ret < 0) {
         TracePrintf(1, "[PipeRead] _buf is not within valid address space\n");
         return ERROR;
@@ -239,62 +320,54 @@ int PipeRead(pipe_list_t *_pl, UserContext *_uctxt, int _pipe_id, void *_buf, in
         return ERROR;
     }
 
-    // 5. Check to see if another process is already waiting on this pipe. If so, save the current
-    //    process' UserContext, add it to our PipeRead blocked list, and switch to the next ready.
-    if (pipe->read_pid) {
-        TracePrintf(1, "[PipeRead] _pipe_id: %d in use by process: %d. Blocking process: %d\n",
-                                      _pipe_id, pipe->read_pid, running_old->pid);
-        running_old->pipe_id = _pipe_id;
-        memcpy(&running_old->uctxt, _uctxt, sizeof(UserContext));
-        SchedulerAddPipeRead(e_scheduler, running_old);
-        KCSwitch(_uctxt, running_old);
-    }
-
-    // 6. Check to see if we already have data ready for the process to read. If we do not have any
-    //    lines ready, mark the process as the next to read from this pipe and add it to the
-    //    PipeRead blocked list. Switch to the next ready process.
-    if (!pipe->buf_len) {
-        TracePrintf(1, "[PipeRead] _pipe_id: %d buf empty. Blocking process: %d\n",
+    // 5. Readers are served in the order they arrive. If other readers are already waiting (or
+    //    one has been woken to read and has not run yet), or if the pipe is empty, get in line at
+    //    the end of the pipe's reader queue and switch to the next ready process. While we wait,
+    //    we leave our output buffer in our pcb so that a writer can copy its bytes straight into
+    //    it once we reach the front of the line (see PipeHandOff).
+    running_old->pipe_done = 0;
+    if (pipe->readers.start || pipe->read_waking || !pipe->buf_len) {
+        TracePrintf(1, "[PipeRead] _pipe_id: %d busy or empty. Blocking process: %d\n",
                                       _pipe_id, running_old->pid);
-        running_old->pipe_id = _pipe_id;
-        pipe->read_pid       = running_old->pid;
+        running_old->pipe_buf = _buf;
+        running_old->pipe_len = _buf_len;
         memcpy(&running_old->uctxt, _uctxt, sizeof(UserContext));
-        SchedulerAddPipeRead(e_scheduler, running_old);
+        SchedulerAddPipeRead(e_scheduler, &pipe->readers, running_old);
         KCSwitch(_uctxt, running_old);
+        running_old->pipe_buf = NULL;
+
+        // 5a. Unless a writer handed us its bytes directly, we were woken by PipeWakeReader since
+        //     we were first in line and the pipe has data, so it is now our turn to read it.
+        if (!running_old->pipe_done) {
+            pipe->read_waking = 0;
+        }
     }
 
-    // 7. At this point, the pipe should be populated with input due to some other process writing
-    //    to it. Copy the pipe data into the user's output buffer (or only part of the line
-    //    depending on the user's buffer size).
-    int read_len = 0;
-    if (_buf_len < pipe->buf_len) {             // if user output buffer is smaller than the number
+    // 6. If a writer handed its bytes to us directly, they are already in the user's buffer.
+    //    Otherwise, the pipe is populated with input due to some other process writing to it.
+    //    Work out how much of the pipe data fits in the user's output buffer.
+    int read_len = running_old->pipe_done;
+    if (read_len) {
+        TracePrintf(1, "[PipeRead] Process: %d was handed %d bytes from pipe: %d\n",
+                                   running_old->pid, read_len, _pipe_id);
+    } else if (_buf_len < pipe->buf_len) {      // if user output buffer is smaller than the number
         read_len = _buf_len;                    // of bytes in our buffer, than only read enough
     } else {                                    // to fill the user buffer. If the user buffer is
         read_len = pipe->buf_len;               // larger, then read the entire pipe buffer
     }
-    memcpy(_buf, pipe->buf, read_len);
-
-    // 8. Check to see if there are any remaining bytes in our pipe. If so, move the remaining
-    //    bytes to the beginning of the pipe buffer and update the buffer length. Otherwise,
-    //    set the pipe length to 0 since we read all of them.
-    if (_buf_len < pipe->buf_len) {
-        int pipe_remainder = pipe->buf_len - _buf_len;
-        memcpy(pipe->buf, pipe->buf + _buf_len, pipe_remainder);
-        pipe->buf_len  = pipe_remainder;
-    } else {
-        pipe->buf_len  = 0;
-    }
-
-    // 9. Lastly, unblock the next processes that are waiting to read or write from/to the pipe.
-    //    Since we just finished reading, we send SchedulerUpdatePipeRead "0" for the read_id to
-    //    indicate that it should return the next waiting process (instead of a specific one).
-    //    It will return the pid of the process it unblocks, or 0 if there are none.
-    //
-    //    For SchedulerUpdatePipeWrite, we send the write_pid of the process currently writing to
-    //    to the pipe. If there is no process currently writing to the pipe (i.e., write_pid = 0)
-    //    then 0 will be returned.
-    pipe->read_pid  = SchedulerUpdatePipeRead(e_scheduler, _pipe_id, 0);
-    pipe->write_pid = SchedulerUpdatePipeWrite(e_scheduler, _pipe_id, pipe->write_pid);
+
+    // 7. Copy the bytes out of the front of the ring buffer, which also advances its head past
+    //    them. Whatever is left stays where it is, so small reads never shift the buffer.
+    if (!running_old->pipe_done) {
+        PipeCopyOut(pipe, _buf, read_len);
+    }
+    running_old->pipe_done = 0;
+
+    // 8. Lastly, if there are bytes left in the pipe, wake the next reader in line to read them.
+    //    We also just made room in the pipe, so wake the writer whose turn it is if it is waiting
+    //    for room to finish its write.
+    PipeWakeReader(pipe);
+    SchedulerUpdatePipeWrite(e_scheduler, &pipe->space);
     return read_len;
 }
 
@@ -304,7 +377,9 @@ int PipeRead(pipe_list_t *_pl, UserContext *_uctxt, int _pipe_id, void *_buf, in
  *                      Unlike read, this function guarantees to write *all* bytes from the
  *                      input buffer into the pipe, though it may require blocking a number of
  *                      times if the input buffer is (1) larger than the available space in the
- *                      pipe or (2) if others are currently writing to the pipe.
+ *                      pipe or (2) if others are currently writing to the pipe. Writers take
+ *                      turns in the order they arrive, and writes of up to PIPE_ATOMIC_LEN bytes
+ *                      are atomic.
  * 
  * \param[in] _pl       An initialized pipe_list_t struct
  * \param[in] _uctxt    The UserContext for the current running process
@@ -343,27 +418,22 @@ int PipeWrite(pipe_list_t *_pl, UserContext *_uctxt, int _pipe_id, void *_buf, i
     // 3. Check that the user output read buffer is within valid memory space. Specifically, every
     //    byte of the buffer should be in the process' region 1 memory space (i.e., in valid pages)
     //    and have write permissions since we are supposed to write the pipe data to it.
-    int ret = PTECheckAddress(running_old->pt,
-                              _buf,
-                              _buf_len,
-                              PROT_READ);
+    int ret = ProcessCheckAddress(running_old,
+                                  _buf,
+                                  _buf_len,
+                                  PROT_READ);
     if (ret < 0) {
         TracePrintf(1, "[PipeWrite] _buf is not within valid address space\n");
         return ERROR;
     }
 
-    // 4. Copy the user's input buffer over into kernel space. The reason we create a copy in the
-    //    kernel is that if we have to block here, its possible that another process with access
-    //    to the input buffer could modify its contents (or the length) to get us to write bad
-    //    data. This way, even if they do modify input buf, we will have an original copy for when
-    //    we get to run again here in the kernel.
-    int   kernel_buf_len = _buf_len;
-    void *kernel_buf = (void *) malloc(kernel_buf_len);
-    if (!kernel_buf) {
-        TracePrintf(1, "[PipeWrite] Error allocating space for kernel_buf\n");
-        return ERROR;
-    }
-    memcpy(kernel_buf, _buf, kernel_buf_len);
+    // 4. We copy straight from the user's input buffer into the pipe, a chunk at a time, rather
+    //    than through a kernel copy of the whole buffer. Remember the part of the buffer left to
+    //    write in our pcb: it is only valid while our own region 1 is loaded, which it is again
+    //    whenever we resume after blocking. No other process can change our region 1 meanwhile,
+    //    and the swapper and page merging leave the pages of a process blocked in the kernel be.
+    running_old->pipe_buf = _buf;
+    running_old->pipe_len = _buf_len;
 
     // 5. Grab the struct for the pipe specified by pipe_id. If its not found, return ERROR.
     pipe_t *pipe = PipeGet(_pl, _pipe_id);
@@ -372,79 +442,71 @@ int PipeWrite(pipe_list_t *_pl, UserContext *_uctxt, int _pipe_id, void *_buf, i
         return ERROR;
     }
 
-    // 5. Check to see if another process is already waiting on this pipe. If so, save the current
-    //    process' UserContext, add it to our PipeWrite blocked list, and switch to the next ready.
-    if (pipe->write_pid) {
-        TracePrintf(1, "[PipeWrite] _pipe_id: %d in use by process: %d. Blocking process: %d\n",
-                                      _pipe_id, pipe->read_pid, running_old->pid);
-        running_old->pipe_id = _pipe_id;
-        memcpy(&running_old->uctxt, _uctxt, sizeof(UserContext));
-        SchedulerAddPipeWrite(e_scheduler, running_old);
-        KCSwitch(_uctxt, running_old);
-    }
-
-    // 6. At this point, we are the only ones allowed to write to the pipe, but we also need to
-    //    check if the pipe is full. If so, mark this process as the next one to write to this
-    //    pipe and add it to our PipeWrite blocked list. Switch to the next ready process.
-    if (pipe->buf_len == PIPE_BUFFER_LEN) {
-        TracePrintf(1, "[PipeWrite] _pipe_id: %d buf full. Blocking process: %d\n",
+    // 6. Writers take turns in the order they arrive, and a writer keeps its turn until all of
+    //    its bytes are in the pipe, so writes are never interleaved. If another writer has the
+    //    turn, get in line at the end of the pipe's writer queue and switch to the next ready
+    //    process. The writer before us passes the turn straight to us when it is done.
+    if (pipe->writing) {
+        TracePrintf(1, "[PipeWrite] _pipe_id: %d in use. Blocking process: %d\n",
                                       _pipe_id, running_old->pid);
-        running_old->pipe_id = _pipe_id;
-        pipe->write_pid      = running_old->pid;
         memcpy(&running_old->uctxt, _uctxt, sizeof(UserContext));
-        SchedulerAddPipeWrite(e_scheduler, running_old);
+        SchedulerAddPipeWrite(e_scheduler, &pipe->writers, running_old);
         KCSwitch(_uctxt, running_old);
     }
+    pipe->writing = 1;
 
-    // 7. If the caller wishes to write more bytes than the pipe currently has space for, we need
-    //    to loop where we (1) write as many bytes as we can (2) unblock the next process (if any)
-    //    that is waiting to read the pipe and (3) block ourselves until the pipe has space again.
-    int   bytes_remaining  = kernel_buf_len;
-    void *kernel_buf_start = kernel_buf;
-    while (bytes_remaining) {
-
-        // 7a. Calculate how much space is left in the pipe buffer. If the number of bytes left to
-        //     write can fit in the available pipe space, then simply write the bytes, update the
-        //     pipe buffer length, and break the loop.
-        int pipe_remaining = PIPE_BUFFER_LEN - pipe->buf_len;
-        if (bytes_remaining <= pipe_remaining) {
-            memcpy(pipe->buf + pipe->buf_len, kernel_buf, bytes_remaining);
-            pipe->buf_len += bytes_remaining;
-            break;
+    // 7. Loop until we have written all of our bytes. Each time around, we either hand bytes to a
+    //    waiting reader, add bytes to the pipe buffer, or wait for readers to make room.
+    while (running_old->pipe_len) {
+
+        // 7a. If the pipe is empty and a reader is waiting for data, skip the pipe buffer and copy
+        //     straight into the first waiting reader's output buffer, then go around again.
+        if (!pipe->buf_len && PipeHandOff(pipe, running_old)) {
+            continue;
+        }
+
+        // 7b. Writes of up to PIPE_ATOMIC_LEN bytes go into the pipe all at once, so we wait until
+        //     there is room for all of them. Larger writes add as many bytes as there is room for.
+        //     In a large pipe, the room also has to be backed by pages, which are allocated here.
+        int pipe_remaining = PipeReserve(pipe, running_old->pipe_len);
+        int needed         = running_old->pipe_len <= PIPE_ATOMIC_LEN ? running_old->pipe_len : 1;
+        if (pipe_remaining >= needed) {
+            int write_len = running_old->pipe_len < pipe_remaining ? running_old->pipe_len
+                                                                   : pipe_remaining;
+            PipeCopyIn(pipe, running_old->pipe_buf, write_len);
+            running_old->pipe_buf += write_len;
+            running_old->pipe_len -= write_len;
+            TracePrintf(1, "[PipeWrite] Process: %d wrote %d bytes to pipe: %d. Remaining: %d\n",
+                           running_old->pid, write_len, _pipe_id, running_old->pipe_len);
+            PipeWakeReader(pipe);
+            continue;
+        }
+
+        // 7c. If the pipe is empty and we still could not get room, we are out of kernel memory
+        //     for its pages. Give up, passing our turn on to the next writer in line.
+        if (!pipe->buf_len) {
+            TracePrintf(1, "[PipeWrite] Out of memory for pipe: %d pages\n", _pipe_id);
+            if (!SchedulerUpdatePipeWrite(e_scheduler, &pipe->writers)) {
+                pipe->writing = 0;
+            }
+            running_old->pipe_buf = NULL;
+            return ERROR;
         }
 
-        // 7b. If we have more remaining bytes than space in the pipe, only write as many bytes as
-        //     will fit in the pipe. Update the pipe buffer length, the start of the kernel buffer,
-        //     and the number of bytes remaining to be written.
-        memcpy(pipe->buf + pipe->buf_len, kernel_buf, pipe_remaining);
-        pipe->buf_len   += pipe_remaining;
-        kernel_buf      += pipe_remaining;
-        bytes_remaining -= pipe_remaining;
-
-        // 7c. Unblock the next process (if any) that is waiting to read this pipe. Then mark
-        //     ourselves as currently writing to the pipe and block until space is available.
-        pipe->read_pid = SchedulerUpdatePipeRead(e_scheduler, _pipe_id, pipe->read_pid);
-        TracePrintf(1, "[PipeWrite] Process: %d wrote %d bytes to pipe: %d. Remaining bytes: %d\n",
-                                    running_old->pid, pipe_remaining, _pipe_id, bytes_remaining);
-        running_old->pipe_id = _pipe_id;
-        pipe->write_pid      = running_old->pid;
+        // 7d. Otherwise, make sure a reader is on its way to drain the pipe, then keep our turn
+        //     and block until a reader makes room.
+        PipeWakeReader(pipe);
         memcpy(&running_old->uctxt, _uctxt, sizeof(UserContext));
-        SchedulerAddPipeWrite(e_scheduler, running_old);
+        SchedulerAddPipeWrite(e_scheduler, &pipe->space, running_old);
         KCSwitch(_uctxt, running_old);
     }
 
-    // 8. Lastly, unblock the next processes that are waiting to read or write from/to the pipe.
-    //    Since we just finished reading, we send SchedulerUpdatePipeWrite "0" for the write_id to
-    //    indicate that it should return the next waiting process (instead of a specific one).
-    //    It will return the pid of the process it unblocks, or 0 if there are none.
-    //
-    //    For SchedulerUpdatePipeRead, we send the read_pid of the process currently reading from
-    //    the pipe. If there is no process currently reading from the pipe (i.e., read_pid = 0)
-    //    then 0 will be returned.
-    pipe->read_pid  = SchedulerUpdatePipeRead(e_scheduler, _pipe_id, pipe->read_pid);
-    pipe->write_pid = SchedulerUpdatePipeWrite(e_scheduler, _pipe_id, 0);
-    free(kernel_buf_start);
-    return kernel_buf_len;
+    // 8. Lastly, pass our turn on to the next writer in line (if any).
+    if (!SchedulerUpdatePipeWrite(e_scheduler, &pipe->writers)) {
+        pipe->writing = 0;
+    }
+    running_old->pipe_buf = NULL;
+    return _buf_len;
 }
 
 
@@ -487,6 +549,104 @@ static int PipeAdd(pipe_list_t *_pl, pipe_t *_pipe) {
 }
 
 
+/*!
+ * \desc             Internal function for appending bytes to the end of a pipe's ring buffer. The
+ *                   free space may wrap around the end of the buffer (and, in a large pipe, span
+ *                   several pages), so it is copied a contiguous piece at a time. The caller must
+ *                   make sure that the bytes fit and are backed (see PipeReserve).
+ *
+ * \param[in] _pipe  The pipe to write the bytes to
+ * \param[in] _buf   The bytes to write
+ * \param[in] _len   The number of bytes to write
+ */
+static void PipeCopyIn(pipe_t *_pipe, void *_buf, int _len) {
+    int done = 0;
+    while (done < _len) {
+        int   chunk;
+        int   tail = (_pipe->buf_head + _pipe->buf_len) % _pipe->buf_size;
+        char *dst  = PipeRange(_pipe, tail, _len - done, &chunk);
+        memcpy(dst, _buf + done, chunk);
+        _pipe->buf_len += chunk;
+        done           += chunk;
+    }
+}
+
+
+/*!
+ * \desc             Internal function for removing bytes from the front of a pipe's ring buffer.
+ *                   The bytes may wrap around the end of the buffer (and, in a large pipe, span
+ *                   several pages), so they are copied a contiguous piece at a time. Each page of
+ *                   a large pipe is freed as soon as it no longer holds any bytes, and all of its
+ *                   pages are freed once it is empty. The caller must make sure that the pipe
+ *                   holds at least _len bytes.
+ *
+ * \param[in]  _pipe  The pipe to read the bytes from
+ * \param[out] _buf   Where to copy the bytes to
+ * \param[in]  _len   The number of bytes to read
+ */
+static void PipeCopyOut(pipe_t *_pipe, void *_buf, int _len) {
+    int done = 0;
+    while (done < _len) {
+        int   chunk;
+        int   page = _pipe->buf_head / PAGESIZE;
+        char *src  = PipeRange(_pipe, _pipe->buf_head, _len - done, &chunk);
+        memcpy(_buf + done, src, chunk);
+        _pipe->buf_head = (_pipe->buf_head + chunk) % _pipe->buf_size;
+        _pipe->buf_len -= chunk;
+        done           += chunk;
+
+        if (_pipe->pages && !PipePageIsLive(_pipe, page)) {
+            free(_pipe->pages[page]);
+            _pipe->pages[page] = NULL;
+        }
+    }
+
+    // Once the pipe is empty, start over at the front of the ring so that a large pipe keeps
+    // reusing its first pages rather than cycling through all of them. Since the tail moves back
+    // too, pages that a waiting writer reserved past the old tail will not be written; free them
+    // (and anything else left) so that a drained pipe holds no pages at all.
+    if (!_pipe->buf_len) {
+        _pipe->buf_head = 0;
+        PipeFreePages(_pipe);
+    }
+}
+
+
+/*!
+ * \desc             Internal function for freeing a pipe struct, along with any pages still
+ *                   backing it if it is a large pipe.
+ *
+ * \param[in] _pipe  The pipe to free
+ */
+static void PipeFree(pipe_t *_pipe) {
+    if (!_pipe->pages) {
+        SlabFree(&g_pipe_cache, _pipe);
+        return;
+    }
+    PipeFreePages(_pipe);
+    free(_pipe->pages);
+    SlabFree(&g_large_pipe_cache, _pipe);
+}
+
+
+/*!
+ * \desc             Internal function for freeing every page backing a large pipe (back to the
+ *                   kernel heap). The caller must make sure that none of them hold any bytes.
+ *
+ * \param[in] _pipe  The pipe whose pages we wish to free (small pipes are left alone)
+ */
+static void PipeFreePages(pipe_t *_pipe) {
+    if (!_pipe->pages) {
+        return;
+    }
+    int num_pages = (_pipe->buf_size + PAGESIZE - 1) / PAGESIZE;
+    for (int i = 0; i < num_pages; i++) {
+        free(_pipe->pages[i]);
+        _pipe->pages[i] = NULL;
+    }
+}
+
+
 /*!
  * \desc                Internal function for retrieving a pipe struct from our pipe list. Note
  *                      that this function does not modify the list---it simply returns a pointer.
@@ -513,6 +673,175 @@ static pipe_t *PipeGet(pipe_list_t *_pl, int _pipe_id) {
 }
 
 
+/*!
+ * \desc                Internal function for copying a writer's bytes straight into the output
+ *                      buffer of the first reader waiting on an empty pipe, rather than through
+ *                      the pipe buffer. The reader's region 1 is not loaded, so each of its pages
+ *                      is mapped in turn to the page right below the kernel stack. Its pages are
+ *                      all resident and private since PipeRead checked the buffer for writing
+ *                      before it blocked, and neither the swapper nor page merging touch blocked
+ *                      processes. The reader is then made ready and returns the number of bytes
+ *                      it was handed.
+ *
+ * \param[in] _pipe     The (empty) pipe being written to
+ * \param[in] _writer   The pcb for the current running process, with pipe_buf/pipe_len set
+ *
+ * \return              The number of bytes handed off, 0 if no reader was waiting on the pipe
+ */
+static int PipeHandOff(pipe_t *_pipe, pcb_t *_writer) {
+    // 1. Readers are served in order, so only the first reader in line gets the bytes.
+    pcb_t *reader = _pipe->readers.start;
+    if (!reader || !reader->pipe_buf) {
+        return 0;
+    }
+    int   temp_page_num  = (KERNEL_STACK_BASE >> PAGESHIFT) - 1;
+    void *temp_page_addr = (void *) (temp_page_num << PAGESHIFT);
+    if (temp_page_addr < e_kernel_curr_brk) {
+        TracePrintf(1, "[PipeHandOff] Kernel heap overlaps the temporary page\n");
+        return 0;
+    }
+
+    // 2. Copy as much as fits in the reader's buffer, one page of the reader's buffer at a time.
+    int len  = _writer->pipe_len < reader->pipe_len ? _writer->pipe_len : reader->pipe_len;
+    int done = 0;
+    while (done < len) {
+        void  *dst    = reader->pipe_buf + done;
+        int    offset = (unsigned int) dst & PAGEOFFSET;
+        int    chunk  = PAGESIZE - offset < len - done ? PAGESIZE - offset : len - done;
+        pte_t *pte    = ProcessPTEGet(reader, PTEAddressToPage(dst) - MAX_PT_LEN);
+        if (!pte) {
+            TracePrintf(1, "[PipeHandOff] Reader: %d buffer page not mapped\n", reader->pid);
+            break;
+        }
+        PTESet(e_kernel_pt, temp_page_num, PROT_READ | PROT_WRITE, pte->pfn);
+        memcpy(temp_page_addr + offset, _writer->pipe_buf + done, chunk);
+        PTEClear(e_kernel_pt, temp_page_num);
+        WriteRegister(REG_TLB_FLUSH, (unsigned int) temp_page_addr);
+        done += chunk;
+    }
+    if (!done) {
+        return 0;
+    }
+
+    // 3. Advance the writer past the bytes we handed off and wake the reader with its count.
+    TracePrintf(1, "[PipeHandOff] Process: %d handed %d bytes to process: %d\n",
+                                  _writer->pid, done, reader->pid);
+    _writer->pipe_buf += done;
+    _writer->pipe_len -= done;
+    reader->pipe_done  = done;
+    SchedulerUpdatePipeRead(e_scheduler, &_pipe->readers);
+    return done;
+}
+
+
+/*!
+ * \desc             Internal function for waking the first reader in line if the pipe has bytes
+ *                   for it to read. Only one reader is woken at a time, and readers that arrive
+ *                   in the meantime get in line behind it, so readers are served in order and a
+ *                   woken reader always finds the bytes it was woken for.
+ *
+ * \param[in] _pipe  The pipe whose readers we wish to wake
+ */
+static void PipeWakeReader(pipe_t *_pipe) {
+    if (_pipe->buf_len && !_pipe->read_waking &&
+        SchedulerUpdatePipeRead(e_scheduler, &_pipe->readers)) {
+        _pipe->read_waking = 1;
+    }
+}
+
+
+/*!
+ * \desc             Internal function for checking whether any of the bytes in a large pipe are
+ *                   stored in the given page of its ring.
+ *
+ * \param[in] _pipe  The (large) pipe
+ * \param[in] _page  The index of the page in the pipe's ring
+ *
+ * \return           1 if the page holds bytes, 0 otherwise
+ */
+static int PipePageIsLive(pipe_t *_pipe, int _page) {
+    // The bytes run from buf_head for buf_len bytes, wrapping around the end of the ring. The page
+    // holds some of them if the head is in the page or the page starts within buf_len of the head.
+    int start = _page * PAGESIZE;
+    int end   = start + PAGESIZE;
+    if (!_pipe->buf_len) {
+        return 0;
+    }
+    if (_pipe->buf_head >= start && _pipe->buf_head < end) {
+        return 1;
+    }
+    return (start - _pipe->buf_head + _pipe->buf_size) % _pipe->buf_size < _pipe->buf_len;
+}
+
+
+/*!
+ * \desc              Internal function for finding the longest contiguous piece of a pipe's ring,
+ *                    starting at _pos and at most _len bytes long. In a large pipe a piece never
+ *                    crosses a page boundary, and its page must already be allocated.
+ *
+ * \param[in]  _pipe   The pipe
+ * \param[in]  _pos    The position in the ring where the piece starts
+ * \param[in]  _len    The most bytes the caller wants
+ * \param[out] _chunk  The length of the piece
+ *
+ * \return            The address of the piece
+ */
+static char *PipeRange(pipe_t *_pipe, int _pos, int _len, int *_chunk) {
+    int limit = _pipe->buf_size - _pos;
+    if (!_pipe->pages) {
+        *_chunk = _len < limit ? _len : limit;
+        return _pipe->buf + _pos;
+    }
+    int offset = _pos % PAGESIZE;
+    if (PAGESIZE - offset < limit) {
+        limit = PAGESIZE - offset;
+    }
+    *_chunk = _len < limit ? _len : limit;
+    return _pipe->pages[_pos / PAGESIZE] + offset;
+}
+
+
+/*!
+ * \desc             Internal function for making room to append up to _len bytes to a pipe. In
+ *                   a large pipe, this allocates any missing pages for the room as well; if the
+ *                   kernel heap runs out, the room stops at the first page we could not get.
+ *
+ * \param[in] _pipe  The pipe the caller wishes to write to
+ * \param[in] _len   The number of bytes the caller wishes to write
+ *
+ * \return           The number of bytes (at most _len) that can be appended right now
+ */
+static int PipeReserve(pipe_t *_pipe, int _len) {
+    // 1. Work out how much free space there is in the ring. A small pipe is always backed.
+    int room = _pipe->buf_size - _pipe->buf_len;
+    if (_len < room) {
+        room = _len;
+    }
+    if (!_pipe->pages) {
+        return room;
+    }
+
+    // 2. Walk the free space from the tail a page at a time, allocating pages that are missing.
+    int backed = 0;
+    while (backed < room) {
+        int chunk;
+        int pos  = (_pipe->buf_head + _pipe->buf_len + backed) % _pipe->buf_size;
+        int page = pos / PAGESIZE;
+        if (!_pipe->pages[page]) {
+            _pipe->pages[page] = (char *) malloc(PAGESIZE);
+            if (!_pipe->pages[page]) {
+                TracePrintf(1, "[PipeReserve] Error allocating page %d for pipe %d\n",
+                                              page, _pipe->pipe_id);
+                break;
+            }
+        }
+        PipeRange(_pipe, pos, room - backed, &chunk);
+        backed += chunk;
+    }
+    return backed;
+}
+
+
 /*!
  * \desc                Internal function for remove a pipe struct from our pipe list. Note that
  *                      this function does modify the list, but does not return a pointer to the
@@ -546,7 +875,7 @@ static int PipeRemove(pipe_list_t *_pl, int _pipe_id) {
         if (_pl->start) {
             _pl->start->prev = NULL;
         }
-        free(pipe);
+        PipeFree(pipe);
         return 0;
     }
 
@@ -555,7 +884,7 @@ static int PipeRemove(pipe_list_t *_pl, int _pipe_id) {
     if (pipe->pipe_id == _pipe_id) {
         _pl->end       = pipe->prev;
         _pl->end->next = NULL;
-        free(pipe);
+        PipeFree(pipe);
         return 0;
     }
 
@@ -567,7 +896,7 @@ static int PipeRemove(pipe_list_t *_pl, int _pipe_id) {
         if (pipe->pipe_id == _pipe_id) {
             pipe->prev->next = pipe->next;
             pipe->next->prev = pipe->prev;
-            free(pipe);
+            PipeFree(pipe);
             return 0;
         }
         pipe = pipe->next;
@@ -1,6 +1,17 @@
 #ifndef __PIPE_H
 #define __PIPE_H
 #include <hardware.h>
+#include <yalnix.h>
+
+// Writes of at most this many bytes are atomic: they go into the pipe all at once, so a reader
+// never sees part of one while its writer is still blocked. Writes are never interleaved with
+// other writers' bytes, however large.
+#define PIPE_ATOMIC_LEN PIPE_BUFFER_LEN
+
+// Largest capacity that PipeInitSized accepts. Pipes larger than PIPE_BUFFER_LEN are backed by
+// PAGESIZE chunks of the kernel heap that are allocated as they fill up and freed (back to the
+// kernel heap) as they are drained.
+#define PIPE_MAX_LEN    (16 * PAGESIZE)
 
 
 typedef struct pipe_list pipe_list_t;
@@ -32,6 +43,26 @@ int PipeListDelete(pipe_list_t *_pl);
 int PipeInit(pipe_list_t *_pl, int *_pipe_id);
 
 
+/*!
+ * \desc                 Creates a new pipe that holds up to _size bytes and saves the id at the
+ *                       caller specified address. Pipes of up to PIPE_BUFFER_LEN bytes keep their
+ *                       bytes inside the pipe struct. Larger pipes are backed by PAGESIZE chunks
+ *                       of the kernel heap that are only allocated as bytes are written to them,
+ *                       and freed again once readers have drained them, so an idle large pipe
+ *                       costs next to nothing. Freed chunks go back to the kernel heap for other
+ *                       kernel allocations to reuse (the kernel brk never shrinks, so no frames
+ *                       are released).
+ *
+ * \param[in]  _pl       An initialized pipe_list_t struct
+ * \param[out] _pipe_id  The address where the newly created pipe's id should be stored
+ * \param[in]  _size     The capacity of the pipe in bytes (at most PIPE_MAX_LEN). Sizes smaller
+ *                       than PIPE_BUFFER_LEN are rounded up to it.
+ * 
+ * \return               0 on success, ERROR otherwise
+ */
+int PipeInitSized(pipe_list_t *_pl, int *_pipe_id, int _size);
+
+
 /*!
  * \desc                Removes the pipe from our pipe list and frees its memory, but *only* if no
  *                      other processes are currenting waiting on it. Otherwise, we return ERROR
@@ -49,9 +80,10 @@ int PipeReclaim(pipe_list_t *_pl, int _pipe_id);
  * \desc                 Reads from the pipe and stores the bytes in the caller's output buffer.
  *                       The caller is not guaranteed to get _buf_len bytes back, however, if
  *                       there are not enough bytes in the pipe---we simply return whatever is
- *                       in the pipe at the time. If there are no bytes or another process is
- *                       currently reading from the pipe, however, the caller is blocked until
- *                       the pipe is free and/or has bytes to read.
+ *                       in the pipe at the time. If there are no bytes or other readers are
+ *                       already waiting on the pipe, however, the caller is blocked until it
+ *                       is its turn and the pipe has bytes to read. Readers are served in the
+ *                       order they arrive.
  * 
  * \param[in]  _pl       An initialized pipe_list_t struct
  * \param[in]  _uctxt    The UserContext for the current running process
@@ -69,7 +101,9 @@ int PipeRead(pipe_list_t *_pl, UserContext *_uctxt, int _pipe_id, void *_buf, in
  *                      Unlike read, this function guarantees to write *all* bytes from the
  *                      input buffer into the pipe, though it may require blocking a number of
  *                      times if the input buffer is (1) larger than the available space in the
- *                      pipe or (2) if others are currently writing to the pipe.
+ *                      pipe or (2) if others are currently writing to the pipe. Writers take
+ *                      turns in the order they arrive, and writes of up to PIPE_ATOMIC_LEN bytes
+ *                      are atomic.
  * 
  * \param[in] _pl       An initialized pipe_list_t struct
  * \param[in] _uctxt    The UserContext for the current running process
@@ -2,10 +2,22 @@
 #include <ykernel.h>
 #include "frame.h"
 #include "kernel.h"
+#include "load_program.h"
+#include "merge.h"
 #include "process.h"
 #include "pte.h"
+#include "swap.h"
 #include "syscall.h"
 
+static void ProcessCtor(void *_process);
+
+static slab_cache_t g_pcb_cache = SLAB_CACHE_INIT("pcb_t", sizeof(pcb_t), ProcessCtor);
+static pte_t        g_pt[MAX_PT_LEN];      // The one flat region 1 table given to PTBR1
+static pcb_t       *g_pt_loaded = NULL;     // Process whose page directory g_pt currently holds
+
+static void ProcessMoveRegion1(pcb_t *_from, pcb_t *_to);
+static void ProcessPTESync(pcb_t *_process, int _page_num);
+
 /*!
  * \desc    Initializes memory for a new pcb_t struct
  *
@@ -23,18 +35,18 @@ pcb_t *ProcessCreate() {
     // 2. Find some free frames for the process' kernel stack and map them to the pages in
     //    the process' kernel stack page table.
     TracePrintf(1, "[ProcessCreate] Mapping kernel stack pages for pid: %d\n", process->pid);
+    int frames[KERNEL_NUMBER_STACK_FRAMES];
+    if (FrameAllocN(KERNEL_NUMBER_STACK_FRAMES, frames) == ERROR) {
+        ProcessDestroy(process);
+        TracePrintf(1, "[ProcessCreate]: Failed to find free frames.\n");
+        return NULL;
+    }
     for (int i = 0; i < KERNEL_NUMBER_STACK_FRAMES; i++) {
-        int frame = FrameFindAndSet();
-        if (frame == ERROR) {
-            ProcessDestroy(process);
-            TracePrintf(1, "[ProcessCreate]: Failed to find a free frame.\n");
-            return NULL;
-        }
         PTESet(process->ks,                         // page table pointer
                i,                                   // page number
                PROT_READ | PROT_WRITE,              // page protection bits
-               frame);                              // frame number
-        TracePrintf(1, "[ProcessCreate] Mapping page: %d to frame: %d\n", i, frame);
+               frames[i]);                          // frame number
+        TracePrintf(1, "[ProcessCreate] Mapping page: %d to frame: %d\n", i, frames[i]);
     }
 
     return process;
@@ -42,31 +54,51 @@ pcb_t *ProcessCreate() {
 
 pcb_t *ProcessCreateIdle() {
     // 1. Allocate space for our process struct. Print message and return NULL upon error
-    pcb_t *process = (pcb_t *) malloc(sizeof(pcb_t));
+    pcb_t *process = (pcb_t *) SlabAlloc(&g_pcb_cache);
     if (!process) {
         TracePrintf(1, "[ProcessCreateIdle] Error mallocing space for process struct\n");
         return NULL;
     }
-
-    bzero(process->ks, sizeof(process->ks[0]) * KERNEL_NUMBER_STACK_FRAMES);
-    bzero(process->pt, sizeof(process->pt[0]) * MAX_PT_LEN);
+    //    Pcbs come out of the cache in their constructed state (see ProcessCtor), so every field
+    //    we do not set below (exited, exit_status, clock_ticks, the page tables, ...) starts at 0
+    //    rather than holding whatever the last process to use this pcb left behind.
 
     // 2. Set the KernelContext to NULL as it will be initialized later by KCCopy. Similarly,
     //    Set the brk and data_end addresses to NULL as they will be set later by LoadProgram.
     process->kctxt    = NULL;
     process->brk      = NULL;
     process->data_end = NULL;
+    process->program  = NULL;
     process->parent = NULL;
     process->headchild = NULL;
     process->sibling = NULL;
     process->res_list = NULL;
+    process->priority      = 0;
+    process->quantum_ticks = 0;
+    process->tickets       = 0;
+    process->stride        = 0;
+    process->pass          = 0;
+    process->queue_next = NULL;
+    process->queue_prev = NULL;
+    process->queue      = NULL;
+    process->hash_next  = NULL;
+    process->hash_prev  = NULL;
+    process->pipe_buf          = NULL;
+    process->pipe_len          = 0;
+    process->pipe_done         = 0;
+    process->vfork_parent      = NULL;
+    process->vfork_queue.start = NULL;
+    process->vfork_queue.end   = NULL;
+
+    process->preempted = 0;
 
     // 3. Assign the process a pid. Note that the build system keeps a mappig of page tables
     //    to pids, so if we don't assign pid via the helper function it complains about the
-    //    PTBR1 not being assigned to a process.
-    process->pid = helper_new_pid(process->pt);
+    //    PTBR1 not being assigned to a process. Every process shares the one flat table that
+    //    PTBR1 points at (see ProcessPTELoad), so that is the table we register.
+    process->pid = helper_new_pid(g_pt);
 
-    // 3. Create a linked list for storing the resources (pipe, lock, cvar) the process created
+    // 4. Create a linked list for storing the resources (pipe, lock, cvar) the process created
     process->res_list = list_new();
     if (process->res_list == NULL) {
         return NULL;
@@ -104,7 +136,7 @@ void ProcessDestroy(pcb_t *_process) {
     }
 
     if (_process->kctxt) {
-        free(_process->kctxt);
+        SlabFree(&e_kctxt_cache, _process->kctxt);
     }
 
     // remove itself from its parent's children list
@@ -122,7 +154,14 @@ void ProcessDestroy(pcb_t *_process) {
     list_foreach(_process->res_list, SyscallReclaim);
     list_free(_process->res_list);
 
-    free(_process);
+    if (g_pt_loaded == _process) {
+        g_pt_loaded = NULL;
+    }
+
+    // Hand the pcb back to the cache in its constructed state, so that the next process to get it
+    // does not inherit our exit status, exited flag, or clock ticks.
+    ProcessCtor(_process);
+    SlabFree(&g_pcb_cache, _process);
  }
 
 /*!
@@ -137,12 +176,14 @@ void ProcessTerminate(pcb_t *_process) {
         Halt();
     }
 
-    // 2. Free the current process' memory by freeing its frames (both region 1 and region 0).
-    for (int i = 0; i < MAX_PT_LEN; i++) {
-        if (_process->pt[i].valid) {
-            FrameClear(_process->pt[i].pfn);
-            PTEClear(_process->pt, i);
-        }
+    // 2. If we borrowed our region 1 from our parent with Vfork, give it back rather than free it.
+    ProcessVforkReturn(_process);
+
+    // 3. Free the current process' memory by freeing its frames (both region 1 and region 0).
+    //    Unmapping every region 1 page also frees all of the leaves of its page directory.
+    for (int i = ProcessPTENext(_process, 0); i != ERROR; i = ProcessPTENext(_process, i + 1)) {
+        FrameClear(ProcessPTEGet(_process, i)->pfn);
+        ProcessPTEClear(_process, i);
     }
 
     for (int i = 0; i < KERNEL_NUMBER_STACK_FRAMES; i++) {
@@ -151,8 +192,344 @@ void ProcessTerminate(pcb_t *_process) {
             PTEClear(_process->ks, i);
         }
     }
+
+    // 4. Drop our references to any swap slots holding our pages and to the executable our text
+    //    and data pages were being loaded from.
+    SwapRelease(_process);
+    LoadProgramRelease(_process);
+}
+
+/*!
+ * \desc                Checks that every byte of a user buffer lies in valid region 1 pages with
+ *                      (at least) the given protections. Any program pages the buffer spans that
+ *                      have not been demand loaded yet are loaded first, and if the caller intends
+ *                      to write to the buffer, any copy-on-write pages it spans are given their
+ *                      own frames, so that the kernel never faults touching the buffer.
+ *
+ * \param[in] _process  The pcb for the current running process (owner of the buffer)
+ * \param[in] _address  The start of the user buffer
+ * \param[in] _length   The length of the user buffer
+ * \param[in] _prot     The protection bits the buffer's pages must have
+ *
+ * \return              0 on success, ERROR otherwise.
+ */
+int ProcessCheckAddress(pcb_t *_process, void *_address, int _length, int _prot) {
+    // 1. Check arguments. Return error if invalid.
+    if (!_process || !_address || _length < 1) {
+        TracePrintf(1, "[ProcessCheckAddress] One or more invalid arguments\n");
+        return ERROR;
+    }
+
+    // 2. Make sure that the buffer lies entirely within region 1.
+    int start_page = PTEAddressToPage(_address)               - MAX_PT_LEN;
+    int end_page   = PTEAddressToPage(_address + _length - 1) - MAX_PT_LEN;
+    if (start_page < 0 || end_page >= MAX_PT_LEN) {
+        TracePrintf(1, "[ProcessCheckAddress] Invalid address: %p. Not within region 1\n",
+                                              _address);
+        return ERROR;
+    }
+
+    // 3. Swap in or load any pages in the buffer that are not resident yet and, if the caller
+    //    wants to write, break copy-on-write sharing. Then check that each page is valid and has
+    //    (at least) the requested protections.
+    for (int i = start_page; i <= end_page; i++) {
+        if (SwapIsSwapped(_process, i) && SwapIn(_process, i) == ERROR) {
+            return ERROR;
+        }
+        if (LoadProgramHasPage(_process, i) && LoadProgramFault(_process, i) == ERROR) {
+            return ERROR;
+        }
+        if ((_prot & PROT_WRITE) && ProcessPTEGetCOW(_process, i) &&
+            ProcessCopyOnWrite(_process, i) == ERROR) {
+            return ERROR;
+        }
+        pte_t *pte = ProcessPTEGet(_process, i);
+        if (!pte || (pte->prot & _prot) != _prot) {
+            TracePrintf(1, "[ProcessCheckAddress] Page: %d not valid or missing prot: %d\n",
+                                                  i, _prot);
+            return ERROR;
+        }
+    }
+    return 0;
+}
+
+
+/*!
+ * \desc                Checks that a NUL-terminated user string lies entirely in valid, readable
+ *                      region 1 pages. The string is checked a page at a time (loading program
+ *                      pages as needed) so that we never read past a page we have not checked.
+ *
+ * \param[in] _process  The pcb for the current running process (owner of the string)
+ * \param[in] _string   The start of the user string
+ *
+ * \return              The length of the string on success, ERROR otherwise.
+ */
+int ProcessCheckString(pcb_t *_process, char *_string) {
+    // 1. Check arguments. Return error if invalid.
+    if (!_process || !_string) {
+        TracePrintf(1, "[ProcessCheckString] One or more invalid arguments\n");
+        return ERROR;
+    }
+
+    // 2. Check the rest of the current page, then scan it for the terminating NUL. If we do not
+    //    find one, move on to the next page.
+    int   length = 0;
+    char *page   = _string;
+    while (1) {
+        char *page_end = (char *) DOWN_TO_PAGE(page) + PAGESIZE;
+        if (ProcessCheckAddress(_process, page, page_end - page, PROT_READ) == ERROR) {
+            return ERROR;
+        }
+        for (; page < page_end; page++, length++) {
+            if (*page == '\0') {
+                return length;
+            }
+        }
+    }
+}
+
+
+/*!
+ * \desc                 Gives a copy-on-write page its own frame so that the process may write
+ *                       to it. If no other page table still shares the frame we simply take it
+ *                       back; otherwise the page is copied into a new frame. The process must be
+ *                       the current running process, since we copy through its region 1 mapping.
+ *
+ * \param[in] _process   The pcb for the current running process
+ * \param[in] _page_num  The region 1 page number of the copy-on-write page
+ *
+ * \return               0 on success, ERROR otherwise.
+ */
+int ProcessCopyOnWrite(pcb_t *_process, int _page_num) {
+    // 1. Check arguments. Return error if invalid.
+    if (!_process || _page_num < 0 || _page_num >= MAX_PT_LEN) {
+        TracePrintf(1, "[ProcessCopyOnWrite] One or more invalid arguments\n");
+        return ERROR;
+    }
+    pte_t *pte = ProcessPTEGet(_process, _page_num);
+    if (!pte || !ProcessPTEGetCOW(_process, _page_num)) {
+        TracePrintf(1, "[ProcessCopyOnWrite] Page %d is not copy-on-write\n", _page_num);
+        return ERROR;
+    }
+
+    // 2. If we are the last process referencing the frame (e.g., the other side of the fork has
+    //    since exited or exec'd), we can keep the frame and just make it writable again.
+    int   pfn       = pte->pfn;
+    void *page_addr = (void *) (VMEM_1_BASE + (_page_num << PAGESHIFT));
+    if (FrameRefCount(pfn) > 1) {
+        // 3. Otherwise, find a new frame and temporarily map it to the page right below the
+        //    kernel stack so that we can copy the shared page's contents into it.
+        int new_pfn = FrameFindAndSet();
+        if (new_pfn == ERROR) {
+            TracePrintf(1, "[ProcessCopyOnWrite] Failed to find a free frame\n");
+            return ERROR;
+        }
+        int   temp_page_num  = (KERNEL_STACK_BASE >> PAGESHIFT) - 1;
+        void *temp_page_addr = (void *) (temp_page_num << PAGESHIFT);
+        if (temp_page_addr < e_kernel_curr_brk) {
+            TracePrintf(1, "[ProcessCopyOnWrite] Kernel heap overlaps the temporary page\n");
+            FrameClear(new_pfn);
+            return ERROR;
+        }
+        PTESet(e_kernel_pt, temp_page_num, PROT_READ | PROT_WRITE, new_pfn);
+        memcpy(temp_page_addr, page_addr, PAGESIZE);
+        PTEClear(e_kernel_pt, temp_page_num);
+        WriteRegister(REG_TLB_FLUSH, (unsigned int) temp_page_addr);
+
+        // 4. Drop our reference to the shared frame and point the page at our private copy.
+        FrameClear(pfn);
+        pfn = new_pfn;
+    }
+
+    // 5. Restore write access to the page and flush its stale read-only TLB entry.
+    if (ProcessPTEGetCOW(_process, _page_num) == MERGE_COW) {
+        MergeUnmerged();
+    }
+    ProcessPTEUpdate(_process, _page_num, pte->prot | PROT_WRITE, pfn);
+    ProcessPTESetCOW(_process, _page_num, 0);
+    WriteRegister(REG_TLB_FLUSH, (unsigned int) page_addr);
+    return 0;
+}
+
+
+/*!
+ * \desc                Unmaps a region 1 page in the process' page directory.
+ *
+ * \param[in] _process   The pcb for the process
+ * \param[in] _page_num  The region 1 page number to unmap (must currently be valid)
+ */
+void ProcessPTEClear(pcb_t *_process, int _page_num) {
+    pte_t *pte = PTEDirGet(&_process->pd, _page_num);
+    if (pte) {
+        SwapUntrack(_process, _page_num, pte->pfn);
+    }
+    PTEDirClear(&_process->pd, _page_num);
+    ProcessPTESync(_process, _page_num);
+}
+
+
+/*!
+ * \desc                Looks up a region 1 page in the process' page directory.
+ *
+ * \param[in] _process   The pcb for the process
+ * \param[in] _page_num  The region 1 page number to look up
+ *
+ * \return              The page's entry if it is valid, NULL otherwise. Use ProcessPTEUpdate
+ *                      rather than writing through the pointer so that the flat table follows.
+ */
+pte_t *ProcessPTEGet(pcb_t *_process, int _page_num) {
+    return PTEDirGet(&_process->pd, _page_num);
+}
+
+
+/*!
+ * \desc                Looks up whether a region 1 page is shared copy-on-write, by fork (1) or by
+ *                      same-page merging (MERGE_COW). Such pages are read-only until first written.
+ *
+ * \param[in] _process   The pcb for the process
+ * \param[in] _page_num  The region 1 page number to look up
+ *
+ * \return              The page's copy-on-write flag, 0 if it has none (or is not in use).
+ */
+int ProcessPTEGetCOW(pcb_t *_process, int _page_num) {
+    return PTEDirGetCOW(&_process->pd, _page_num);
+}
+
+
+/*!
+ * \desc                Returns the flat region 1 table to be written to PTBR1, holding the process'
+ *                      mappings. There is only one flat table, shared by all processes, so it is
+ *                      rebuilt from the process' page directory unless it already holds them
+ *                      (while loaded, it is kept up to date as the directory changes). Processes
+ *                      that are not running (idle and zombies in particular) only pay for their
+ *                      page directories.
+ *
+ * \param[in] _process  The pcb for the process that is about to run (or be loaded into)
+ *
+ * \return             The flat page table, now holding the process' mappings.
+ */
+pte_t *ProcessPTELoad(pcb_t *_process) {
+    if (g_pt_loaded != _process) {
+        PTEDirLoad(&_process->pd, g_pt);
+        g_pt_loaded = _process;
+    }
+    return g_pt;
+}
+
+
+/*!
+ * \desc                Iterates over the valid region 1 mappings of a process (see PTEDirNext).
+ *
+ * \param[in] _process   The pcb for the process
+ * \param[in] _page_num  The page number to start searching from
+ *
+ * \return              The first valid page number >= _page_num, ERROR if there are none.
+ */
+int ProcessPTENext(pcb_t *_process, int _page_num) {
+    return PTEDirNext(&_process->pd, _page_num);
+}
+
+
+/*!
+ * \desc                Maps a region 1 page in the process' page directory.
+ *
+ * \param[in] _process   The pcb for the process
+ * \param[in] _page_num  The region 1 page number to map (must currently be invalid)
+ * \param[in] _prot      The page protection bits
+ * \param[in] _pfn       The frame to map the page to
+ *
+ * \return              0 on success, ERROR if the page directory could not grow to hold the page
+ *                      (the kernel heap is out of space), in which case the caller still owns
+ *                      the frame.
+ */
+int ProcessPTESet(pcb_t *_process, int _page_num, int _prot, int _pfn) {
+    if (PTEDirSet(&_process->pd, _page_num, _prot, _pfn) == ERROR) {
+        return ERROR;
+    }
+    ProcessPTESync(_process, _page_num);
+    SwapTrack(_process, _page_num, _pfn);
+    return 0;
+}
+
+
+/*!
+ * \desc                Sets the copy-on-write flag of a region 1 page (see ProcessPTEGetCOW). The
+ *                      flag is kept in the page directory's leaf and goes away with the page's
+ *                      entry when it is cleared.
+ *
+ * \param[in] _process   The pcb for the process
+ * \param[in] _page_num  The region 1 page number (must currently be valid or swapped out)
+ * \param[in] _cow       The new flag
+ */
+void ProcessPTESetCOW(pcb_t *_process, int _page_num, int _cow) {
+    PTEDirSetCOW(&_process->pd, _page_num, _cow);
+}
+
+
+/*!
+ * \desc                Changes the protections and/or frame of a valid region 1 page. The caller
+ *                      is responsible for flushing the page from the TLB.
+ *
+ * \param[in] _process   The pcb for the process
+ * \param[in] _page_num  The region 1 page number to change (must currently be valid)
+ * \param[in] _prot      The new page protection bits
+ * \param[in] _pfn       The new frame for the page
+ */
+void ProcessPTEUpdate(pcb_t *_process, int _page_num, int _prot, int _pfn) {
+    pte_t *pte = PTEDirGet(&_process->pd, _page_num);
+    if (!pte) {
+        TracePrintf(1, "[ProcessPTEUpdate] Page: %d is not valid\n", _page_num);
+        Halt();
+    }
+    if (pte->pfn != _pfn) {
+        SwapUntrack(_process, _page_num, pte->pfn);
+        SwapTrack(_process, _page_num, _pfn);
+    }
+    pte->prot = _prot;
+    pte->pfn  = _pfn;
+    ProcessPTESync(_process, _page_num);
+}
+
+
+/*!
+ * \desc                Lends the parent's region 1 (its page directory, copy-on-write flags, brk
+ *                      and program) to a child created by Vfork. The parent is left with an empty
+ *                      region 1 until the child gives it back with ProcessVforkReturn.
+ *
+ * \param[in] _parent   The pcb for the current running process
+ * \param[in] _child    The pcb for its new child
+ */
+void ProcessVforkLend(pcb_t *_parent, pcb_t *_child) {
+    ProcessMoveRegion1(_parent, _child);
+    _child->vfork_parent = _parent;
+}
+
+
+/*!
+ * \desc                If the process is running in a region 1 it borrowed with Vfork, gives it
+ *                      back to the parent and wakes the parent up. The process is left with an
+ *                      empty region 1. Called when the process Execs or Exits.
+ *
+ * \param[in] _process  The pcb for the current running process
+ */
+void ProcessVforkReturn(pcb_t *_process) {
+    // 1. Nothing to do if we did not borrow our region 1.
+    pcb_t *parent = _process->vfork_parent;
+    if (!parent) {
+        return;
+    }
+
+    // 2. Move region 1 back and wake the parent. The flat table still holds the parent's mappings
+    //    and is the one the hardware is using, so reload it with ours (now empty) and flush the
+    //    parent's translations out of the TLB.
+    ProcessMoveRegion1(_process, parent);
+    _process->vfork_parent = NULL;
+    SchedulerUpdateVfork(e_scheduler, &_process->vfork_queue);
+    ProcessPTELoad(_process);
+    WriteRegister(REG_TLB_FLUSH, TLB_FLUSH_1);
 }
 
+
 /*!
  * \desc    Add a child process's link to its parent
  */
@@ -191,4 +568,65 @@ void ProcessRemoveChild(pcb_t *_parent, pcb_t *_child) {
             ;
         end->sibling = _child->sibling;
     }
-}
\ No newline at end of file
+}
+
+
+/*!
+ * \desc                Slab constructor for pcbs. Puts a pcb in its constructed state, which is
+ *                      simply all zeros (no pid, not exited, no page tables, on no queue). It is
+ *                      run when a pcb is first carved out of a slab, and again by ProcessDelete
+ *                      before the pcb goes back to the cache, so a new pcb always starts clean.
+ *
+ * \param[in] _process  The pcb to construct
+ */
+static void ProcessCtor(void *_process) {
+    bzero(_process, sizeof(pcb_t));
+}
+
+
+/*!
+ * \desc                Moves a whole region 1 from one process to another, without touching any
+ *                      frames: the page directory's leaves simply change hands. The flat table is
+ *                      rebuilt the next time either process is loaded.
+ *
+ * \param[in] _from     The pcb for the process giving up its region 1
+ * \param[in] _to       The pcb for the process receiving it (whose region 1 must be empty)
+ */
+static void ProcessMoveRegion1(pcb_t *_from, pcb_t *_to) {
+    // 1. Move the directory (and with it the copy-on-write flags in its leaves), brk and program
+    //    over, leaving _from empty.
+    memcpy(&_to->pd, &_from->pd, sizeof(_to->pd));
+    bzero(&_from->pd, sizeof(_from->pd));
+    _to->brk        = _from->brk;
+    _to->data_end   = _from->data_end;
+    _to->program    = _from->program;
+    _from->program  = NULL;
+    if (g_pt_loaded == _from || g_pt_loaded == _to) {
+        g_pt_loaded = NULL;
+    }
+
+    // 2. The frame reverse map names the process that maps each frame, so point it at _to.
+    for (int i = ProcessPTENext(_to, 0); i != ERROR; i = ProcessPTENext(_to, i + 1)) {
+        int pfn = ProcessPTEGet(_to, i)->pfn;
+        SwapUntrack(_from, i, pfn);
+        SwapTrack(_to, i, pfn);
+    }
+}
+
+
+/*!
+ * \desc                Keeps the flat table in step with the process' page directory after a page
+ *                      changes. If the flat table does not hold the process' mappings there is
+ *                      nothing to do, since ProcessPTELoad rebuilds it when the process is loaded.
+ */
+static void ProcessPTESync(pcb_t *_process, int _page_num) {
+    if (_process != g_pt_loaded) {
+        return;
+    }
+    pte_t *pte = PTEDirGet(&_process->pd, _page_num);
+    if (pte) {
+        g_pt[_page_num] = *pte;
+    } else {
+        bzero(&g_pt[_page_num], sizeof(pte_t));
+    }
+}
@@ -2,33 +2,64 @@
 #define __PROCESS_H
 #include <hardware.h>
 #include "dllist.h"
+#include "pte.h"
 
 #define KERNEL_NUMBER_STACK_FRAMES KERNEL_STACK_MAXSIZE / PAGESIZE
 
+
+/*
+ * A FIFO of pcbs that is linked through the queue_next/queue_prev fields embedded in each pcb,
+ * so adding or removing a process never allocates. A process can be on at most one queue at a
+ * time, and its queue field points to the queue it is currently on (or NULL if none).
+ */
+typedef struct pcb_queue {
+    struct pcb *start;
+    struct pcb *end;
+} pcb_queue_t;
+
 // TODO: Add a char *name field for debugging/readability?
 typedef struct pcb {
     int  pid;
     int  clock_ticks;
+    unsigned long wake_tick; // Scheduler tick at which a delayed process should wake up
+    int  priority;          // MLFQ priority level (0 is the highest)
+    int  quantum_ticks;     // Ticks used so far of the quantum at the current priority level
+    int  tickets;           // Stride scheduling tickets (cpu share)
+    unsigned long stride;   // Stride scheduling step, inversely proportional to tickets
+    unsigned long pass;     // Stride scheduling virtual time; smallest pass runs next
     int  exit_status;       // for saving the process's exit status, See Page 32
     int  exited;            // if the process has exited?
-    int  cvar_id;
-    int  lock_id;
-    int  pipe_id;
-    int  tty_id;
     dllist *res_list;
 
     struct pcb *parent;     // For keeping track of parent process
     struct pcb *headchild;   // For keeping track of children processes
     struct pcb *sibling;
 
+    struct pcb  *queue_next;    // Intrusive links for the scheduler queue the process is on
+    struct pcb  *queue_prev;
+    pcb_queue_t *queue;         // The queue the process is currently on (NULL if none)
+    struct pcb  *hash_next;     // Intrusive links for the scheduler's pid-hashed process table
+    struct pcb  *hash_prev;
+
     KernelContext *kctxt;   // Needed for KernelCopy? See Page 45
     UserContext uctxt;
 
     pte_t ks[KERNEL_NUMBER_STACK_FRAMES];
-    pte_t pt[MAX_PT_LEN];
+    pte_dir_t pd;           // Sparse region 1 page table, loaded into the shared flat table for
+                            // REG_PTBR1 while we run (see ProcessPTELoad)
+    int       preempted;    // Whether the process was switched out by the clock while in user mode
+                            // (or is sleeping in Delay), so the kernel won't touch its pages
 
     void *brk;
     void *data_end;
+    struct program *program;    // Executable that text/data pages are demand loaded from
+
+    void *pipe_buf;         // What is left of the user buffer of a blocked PipeWrite, or the
+    int   pipe_len;         // output buffer of a PipeRead parked on an empty pipe
+    int   pipe_done;        // Bytes a writer copied straight into that PipeRead buffer
+
+    struct pcb  *vfork_parent;  // Process whose region 1 we borrowed with Vfork (until Exec/Exit)
+    pcb_queue_t  vfork_queue;   // Where that process waits to get its region 1 back
 } pcb_t;
 
 
@@ -36,6 +67,19 @@ pcb_t *ProcessCreate();
 pcb_t *ProcessCreateIdle();
 
 void ProcessTerminate(pcb_t *_process);
+int  ProcessCheckAddress(pcb_t *_process, void *_address, int _length, int _prot);
+int  ProcessCheckString(pcb_t *_process, char *_string);
+int  ProcessCopyOnWrite(pcb_t *_process, int _page_num);
+void ProcessPTEClear(pcb_t *_process, int _page_num);
+pte_t *ProcessPTEGet(pcb_t *_process, int _page_num);
+int  ProcessPTEGetCOW(pcb_t *_process, int _page_num);
+pte_t *ProcessPTELoad(pcb_t *_process);
+int  ProcessPTENext(pcb_t *_process, int _page_num);
+int  ProcessPTESet(pcb_t *_process, int _page_num, int _prot, int _pfn);
+void ProcessPTESetCOW(pcb_t *_process, int _page_num, int _cow);
+void ProcessPTEUpdate(pcb_t *_process, int _page_num, int _prot, int _pfn);
+void ProcessVforkLend(pcb_t *_parent, pcb_t *_child);
+void ProcessVforkReturn(pcb_t *_process);
 void ProcessDelete(pcb_t *_process);
 void ProcessDestroy(pcb_t *_process);
 void ProcessAddChild(pcb_t *_parent, pcb_t *_child);
@@ -4,6 +4,14 @@
 #include "hardware.h"
 #include "pte.h"
 #include "kernel.h"
+#include "slab.h"
+
+// Leaf tables for the sparse region 1 page directories (see pte.h)
+static slab_cache_t g_leaf_cache = SLAB_CACHE_INIT("pte_leaf", sizeof(pte_leaf_t), NULL);
+
+static pte_leaf_t *PTEDirLeafGet(pte_dir_t *_pd, int _page_num);
+static void   PTEDirLeafPut(pte_dir_t *_pd, int _page_num);
+static int    PTEMapNext(unsigned int *_map, int _page_num);
 
 
 int PTEAddressToPage(void *_address) {
@@ -33,8 +41,8 @@ int PTECheckAddress(pte_t *_pt, void *_address, int _length, int _prot) {
 
     // 3. Calculate the number of pages that the buffer spans. For the start page, we had to check
     //    that it was not below region 1, but for the end page we need to make sure that it is not
-    //    above region 1.
-    int end_page = PTEAddressToPage(_address + _length) - MAX_PT_LEN;
+    //    above region 1. Note that the last byte of the buffer is at _address + _length - 1.
+    int end_page = PTEAddressToPage(_address + _length - 1) - MAX_PT_LEN;
     if (end_page >= MAX_PT_LEN) {
         TracePrintf(1, "[PTECheckAddress] Invalid address: %p. Points above region 1\n",
                                           _address + _length);
@@ -158,4 +166,314 @@ void PTESet(pte_t *_pt, int _page_num, int _prot, int _pfn) {
     _pt[_page_num].valid = 1;
     _pt[_page_num].prot  = _prot;
     _pt[_page_num].pfn   = _pfn;
-}
\ No newline at end of file
+}
+
+
+/*!
+ * \desc                Unmaps a page in a sparse page directory, freeing its leaf table if this
+ *                      was the last valid page in it.
+ *
+ * \param[in] _pd        The page directory
+ * \param[in] _page_num  The region 1 page number to unmap (must currently be valid)
+ */
+void PTEDirClear(pte_dir_t *_pd, int _page_num) {
+    // 1. Check arguments. The page must be mapped; like PTEClear, halt if it is not.
+    if (!_pd || _page_num < 0 || _page_num >= MAX_PT_LEN) {
+        TracePrintf(1, "[PTEDirClear] Invalid directory pointer or page number: %d\n", _page_num);
+        Halt();
+    }
+    int         dir_index = _page_num >> PTE_LEAF_SHIFT;
+    pte_leaf_t *leaf      = _pd->leaves[dir_index];
+    if (!leaf) {
+        TracePrintf(1, "[PTEDirClear] Warning: page %d is alread invalid\n", _page_num);
+        Halt();
+    }
+
+    // 2. Clear the entry (and its copy-on-write flag), and give the leaf back once nothing in it
+    //    is mapped anymore.
+    PTEClear(leaf->ptes, _page_num & (PTE_LEAF_LEN - 1));
+    leaf->cow[_page_num & (PTE_LEAF_LEN - 1)] = 0;
+    _pd->valid_map[_page_num / PTE_MAP_BITS] &= ~(1u << (_page_num % PTE_MAP_BITS));
+    PTEDirLeafPut(_pd, _page_num);
+}
+
+
+/*!
+ * \desc                Forgets a swapped out page (e.g., once it has been swapped back in or its
+ *                      process has exited), freeing its leaf table if nothing else is in it.
+ *
+ * \param[in] _pd        The page directory
+ * \param[in] _page_num  The region 1 page number (must currently be swapped out)
+ */
+void PTEDirClearSwapped(pte_dir_t *_pd, int _page_num) {
+    if (PTEDirGetSwapped(_pd, _page_num, NULL) == ERROR) {
+        TracePrintf(1, "[PTEDirClearSwapped] Page: %d is not swapped out\n", _page_num);
+        Halt();
+    }
+    pte_leaf_t *leaf = _pd->leaves[_page_num >> PTE_LEAF_SHIFT];
+    bzero(&leaf->ptes[_page_num & (PTE_LEAF_LEN - 1)], sizeof(pte_t));
+    leaf->cow[_page_num & (PTE_LEAF_LEN - 1)] = 0;
+    _pd->swap_map[_page_num / PTE_MAP_BITS] &= ~(1u << (_page_num % PTE_MAP_BITS));
+    PTEDirLeafPut(_pd, _page_num);
+}
+
+
+/*!
+ * \desc                Looks up a page in a sparse page directory.
+ *
+ * \param[in] _pd        The page directory
+ * \param[in] _page_num  The region 1 page number to look up
+ *
+ * \return              A pointer to the page's entry if it is valid, NULL otherwise.
+ */
+pte_t *PTEDirGet(pte_dir_t *_pd, int _page_num) {
+    if (!_pd || _page_num < 0 || _page_num >= MAX_PT_LEN) {
+        return NULL;
+    }
+    pte_leaf_t *leaf = _pd->leaves[_page_num >> PTE_LEAF_SHIFT];
+    if (!leaf || !leaf->ptes[_page_num & (PTE_LEAF_LEN - 1)].valid) {
+        return NULL;
+    }
+    return &leaf->ptes[_page_num & (PTE_LEAF_LEN - 1)];
+}
+
+
+/*!
+ * \desc                Looks up the copy-on-write flag of a page in a sparse page directory.
+ *
+ * \param[in] _pd        The page directory
+ * \param[in] _page_num  The region 1 page number to look up
+ *
+ * \return              The page's flag (0 if it is not copy-on-write or not in use).
+ */
+int PTEDirGetCOW(pte_dir_t *_pd, int _page_num) {
+    if (!_pd || _page_num < 0 || _page_num >= MAX_PT_LEN) {
+        return 0;
+    }
+    pte_leaf_t *leaf = _pd->leaves[_page_num >> PTE_LEAF_SHIFT];
+    if (!leaf) {
+        return 0;
+    }
+    return leaf->cow[_page_num & (PTE_LEAF_LEN - 1)];
+}
+
+
+/*!
+ * \desc                 Looks up a swapped out page in a sparse page directory.
+ *
+ * \param[in]  _pd        The page directory
+ * \param[in]  _page_num  The region 1 page number to look up
+ * \param[out] _prot      If not NULL, where to store the protections the page had
+ *
+ * \return               The page's swap slot if it is swapped out, ERROR otherwise.
+ */
+int PTEDirGetSwapped(pte_dir_t *_pd, int _page_num, int *_prot) {
+    if (!_pd || _page_num < 0 || _page_num >= MAX_PT_LEN ||
+        !(_pd->swap_map[_page_num / PTE_MAP_BITS] & (1u << (_page_num % PTE_MAP_BITS)))) {
+        return ERROR;
+    }
+    pte_t *pte = &_pd->leaves[_page_num >> PTE_LEAF_SHIFT]->ptes[_page_num & (PTE_LEAF_LEN - 1)];
+    if (_prot) {
+        *_prot = pte->prot;
+    }
+    return pte->pfn;
+}
+
+
+/*!
+ * \desc          Materializes the flat page table that the hardware reads at REG_PTBR1 from a
+ *                sparse page directory. Unallocated leaves become runs of invalid entries.
+ *
+ * \param[in]  _pd  The page directory
+ * \param[out] _pt  A flat table of MAX_PT_LEN entries
+ */
+void PTEDirLoad(pte_dir_t *_pd, pte_t *_pt) {
+    if (!_pd || !_pt) {
+        TracePrintf(1, "[PTEDirLoad] Invalid directory or page table pointer\n");
+        Halt();
+    }
+    for (int i = 0; i < PTE_DIR_LEN; i++) {
+        if (_pd->leaves[i]) {
+            memcpy(&_pt[i << PTE_LEAF_SHIFT], _pd->leaves[i]->ptes, sizeof(pte_t) * PTE_LEAF_LEN);
+        } else {
+            bzero(&_pt[i << PTE_LEAF_SHIFT], sizeof(pte_t) * PTE_LEAF_LEN);
+        }
+    }
+}
+
+
+/*!
+ * \desc                Iterates over the valid mappings in a sparse page directory using its
+ *                      valid page bitmap, so runs of invalid pages are skipped a word at a time
+ *                      rather than an entry at a time. Typical use:
+ *
+ *                          for (int i = PTEDirNext(pd, 0); i != ERROR; i = PTEDirNext(pd, i + 1))
+ *
+ * \param[in] _pd        The page directory
+ * \param[in] _page_num  The page number to start searching from
+ *
+ * \return              The first valid page number >= _page_num, ERROR if there are none.
+ */
+int PTEDirNext(pte_dir_t *_pd, int _page_num) {
+    if (!_pd) {
+        return ERROR;
+    }
+    return PTEMapNext(_pd->valid_map, _page_num);
+}
+
+
+/*!
+ * \desc                Iterates over the swapped out pages in a sparse page directory (see
+ *                      PTEDirNext).
+ *
+ * \param[in] _pd        The page directory
+ * \param[in] _page_num  The page number to start searching from
+ *
+ * \return              The first swapped out page number >= _page_num, ERROR if there are none.
+ */
+int PTEDirNextSwapped(pte_dir_t *_pd, int _page_num) {
+    if (!_pd) {
+        return ERROR;
+    }
+    return PTEMapNext(_pd->swap_map, _page_num);
+}
+
+
+/*!
+ * \desc                Maps a page in a sparse page directory, allocating its leaf table if this
+ *                      is the first page mapped in it.
+ *
+ * \param[in] _pd        The page directory
+ * \param[in] _page_num  The region 1 page number to map (must currently be invalid)
+ * \param[in] _prot      The page protection bits
+ * \param[in] _pfn       The frame to map the page to
+ *
+ * \return              0 on success, ERROR if the leaf table could not be allocated.
+ */
+int PTEDirSet(pte_dir_t *_pd, int _page_num, int _prot, int _pfn) {
+    // 1. Check arguments. PTESet checks the frame number and that the page is not yet valid.
+    if (!_pd || _page_num < 0 || _page_num >= MAX_PT_LEN) {
+        TracePrintf(1, "[PTEDirSet] Invalid directory pointer or page number: %d\n", _page_num);
+        Halt();
+    }
+
+    if (PTEDirGetSwapped(_pd, _page_num, NULL) != ERROR) {
+        TracePrintf(1, "[PTEDirSet] Page: %d is swapped out\n", _page_num);
+        Halt();
+    }
+
+    // 2. Get the leaf covering the page (allocating it if nothing in it has been mapped yet),
+    //    then map the page.
+    pte_leaf_t *leaf = PTEDirLeafGet(_pd, _page_num);
+    if (!leaf) {
+        return ERROR;
+    }
+    PTESet(leaf->ptes, _page_num & (PTE_LEAF_LEN - 1), _prot, _pfn);
+    _pd->valid_map[_page_num / PTE_MAP_BITS] |= 1u << (_page_num % PTE_MAP_BITS);
+    return 0;
+}
+
+
+/*!
+ * \desc                Sets the copy-on-write flag of a page in a sparse page directory. The flag
+ *                      is cleared along with the page's entry (by PTEDirClear or
+ *                      PTEDirClearSwapped), so callers that clear an entry only to set it again
+ *                      must carry the flag over themselves.
+ *
+ * \param[in] _pd        The page directory
+ * \param[in] _page_num  The region 1 page number (must currently be valid or swapped out)
+ * \param[in] _cow       The new flag (0 if the page is no longer copy-on-write)
+ */
+void PTEDirSetCOW(pte_dir_t *_pd, int _page_num, int _cow) {
+    if (!PTEDirGet(_pd, _page_num) && PTEDirGetSwapped(_pd, _page_num, NULL) == ERROR) {
+        TracePrintf(1, "[PTEDirSetCOW] Page: %d is not in use\n", _page_num);
+        Halt();
+    }
+    _pd->leaves[_page_num >> PTE_LEAF_SHIFT]->cow[_page_num & (PTE_LEAF_LEN - 1)] = _cow;
+}
+
+
+/*!
+ * \desc                Records that a page has been swapped out. The page's entry stays invalid,
+ *                      but remembers its protections and swap slot until PTEDirClearSwapped.
+ *
+ * \param[in] _pd        The page directory
+ * \param[in] _page_num  The region 1 page number (must be neither valid nor swapped out)
+ * \param[in] _prot      The protections to restore when the page is swapped back in
+ * \param[in] _slot      The swap slot holding the page's contents
+ *
+ * \return              0 on success, ERROR if the leaf table could not be allocated.
+ */
+int PTEDirSetSwapped(pte_dir_t *_pd, int _page_num, int _prot, int _slot) {
+    // 1. Check arguments.
+    if (!_pd || _page_num < 0 || _page_num >= MAX_PT_LEN || _slot < 0) {
+        TracePrintf(1, "[PTEDirSetSwapped] Invalid directory, page: %d or slot: %d\n",
+                                           _page_num, _slot);
+        Halt();
+    }
+    if (PTEDirGet(_pd, _page_num) || PTEDirGetSwapped(_pd, _page_num, NULL) != ERROR) {
+        TracePrintf(1, "[PTEDirSetSwapped] Page: %d is already in use\n", _page_num);
+        Halt();
+    }
+
+    // 2. Fill in the (still invalid) entry with the protections and slot.
+    pte_leaf_t *leaf = PTEDirLeafGet(_pd, _page_num);
+    if (!leaf) {
+        return ERROR;
+    }
+    leaf->ptes[_page_num & (PTE_LEAF_LEN - 1)].prot = _prot;
+    leaf->ptes[_page_num & (PTE_LEAF_LEN - 1)].pfn  = _slot;
+    _pd->swap_map[_page_num / PTE_MAP_BITS] |= 1u << (_page_num % PTE_MAP_BITS);
+    return 0;
+}
+
+
+static pte_leaf_t *PTEDirLeafGet(pte_dir_t *_pd, int _page_num) {
+    // 1. Allocate the leaf covering the page if nothing in it is in use yet (returning NULL if
+    //    the kernel heap is out of space). Either way, count the entry that the caller is about
+    //    to use.
+    int dir_index = _page_num >> PTE_LEAF_SHIFT;
+    if (!_pd->leaves[dir_index]) {
+        _pd->leaves[dir_index] = (pte_leaf_t *) SlabAlloc(&g_leaf_cache);
+        if (!_pd->leaves[dir_index]) {
+            TracePrintf(1, "[PTEDirLeafGet] Error allocating leaf table for page: %d\n",
+                                            _page_num);
+            return NULL;
+        }
+        bzero(_pd->leaves[dir_index], sizeof(pte_leaf_t));
+    }
+    _pd->num_valid[dir_index]++;
+    return _pd->leaves[dir_index];
+}
+
+
+static void PTEDirLeafPut(pte_dir_t *_pd, int _page_num) {
+    // 1. Drop the count for an entry that is no longer in use, and give the leaf back once
+    //    nothing in it is.
+    int dir_index = _page_num >> PTE_LEAF_SHIFT;
+    _pd->num_valid[dir_index]--;
+    if (!_pd->num_valid[dir_index]) {
+        SlabFree(&g_leaf_cache, _pd->leaves[dir_index]);
+        _pd->leaves[dir_index] = NULL;
+    }
+}
+
+
+static int PTEMapNext(unsigned int *_map, int _page_num) {
+    // 1. Check arguments. Running off the end of region 1 just ends the iteration.
+    if (_page_num < 0 || _page_num >= MAX_PT_LEN) {
+        return ERROR;
+    }
+
+    // 2. Mask off the bits below _page_num in its word, then return the lowest set bit of the
+    //    first non-empty word from there on.
+    int          word = _page_num / PTE_MAP_BITS;
+    unsigned int bits = _map[word] & (~0u << (_page_num % PTE_MAP_BITS));
+    while (!bits) {
+        if (++word >= PTE_MAP_LEN) {
+            return ERROR;
+        }
+        bits = _map[word];
+    }
+    return word * PTE_MAP_BITS + __builtin_ctz(bits);
+}
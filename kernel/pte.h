@@ -2,9 +2,54 @@
 #define __PTE_H
 #include <hardware.h>
 
+// Region 1 page tables are kept sparse. A pte_dir_t points to leaf tables of PTE_LEAF_LEN entries
+// each, and a leaf is only allocated once one of its pages is mapped (and is freed again when its
+// last page is unmapped), so a process only pays for the parts of region 1 it actually uses. The
+// hardware still needs a flat table at REG_PTBR1, which PTEDirLoad builds from the directory.
+//
+// The directory also keeps a bitmap of its valid pages, so that PTEDirNext can find the next
+// mapped page a word at a time and walking a process' mappings costs time proportional to the
+// number of pages it has mapped rather than to the size of region 1.
+//
+// A page that has been swapped out keeps an (invalid) entry in its leaf holding its protections
+// and swap slot in place of a frame number, and is tracked in a second bitmap.
+//
+// Each leaf also holds a copy-on-write flag for each of its entries (see PTEDirGetCOW), so that
+// the flags only take space for the parts of region 1 that are in use.
+#define PTE_LEAF_SHIFT  4
+#define PTE_LEAF_LEN    (1 << PTE_LEAF_SHIFT)
+#define PTE_DIR_LEN     (MAX_PT_LEN / PTE_LEAF_LEN)
+#define PTE_MAP_BITS    32
+#define PTE_MAP_LEN     (MAX_PT_LEN / PTE_MAP_BITS)
+
+typedef struct pte_leaf {
+    pte_t ptes[PTE_LEAF_LEN];
+    char  cow[PTE_LEAF_LEN];                // Nonzero iff the page is shared copy-on-write
+} pte_leaf_t;
+
+typedef struct pte_dir {
+    pte_leaf_t  *leaves[PTE_DIR_LEN];
+    short        num_valid[PTE_DIR_LEN];    // Number of valid or swapped entries in each leaf
+    unsigned int valid_map[PTE_MAP_LEN];    // Bit i is set iff page i is valid
+    unsigned int swap_map[PTE_MAP_LEN];     // Bit i is set iff page i is swapped out
+} pte_dir_t;
+
 int  PTEAddressToPage(void *_address);
 int  PTECheckAddress(pte_t *_pt, void *_address, int _length, int _prot);
 void PTEClear(pte_t *_pt, int _page_num);
 void PTESet(pte_t *_pt, int _page_num, int _prot, int _pfn);
 void PTEPrint(pte_t *_pt);
-#endif // __PTE_H
\ No newline at end of file
+
+void   PTEDirClear(pte_dir_t *_pd, int _page_num);
+pte_t *PTEDirGet(pte_dir_t *_pd, int _page_num);
+int    PTEDirGetCOW(pte_dir_t *_pd, int _page_num);
+void   PTEDirLoad(pte_dir_t *_pd, pte_t *_pt);
+int    PTEDirNext(pte_dir_t *_pd, int _page_num);
+int    PTEDirSet(pte_dir_t *_pd, int _page_num, int _prot, int _pfn);
+void   PTEDirSetCOW(pte_dir_t *_pd, int _page_num, int _cow);
+
+void   PTEDirClearSwapped(pte_dir_t *_pd, int _page_num);
+int    PTEDirGetSwapped(pte_dir_t *_pd, int _page_num, int *_prot);
+int    PTEDirNextSwapped(pte_dir_t *_pd, int _page_num);
+int    PTEDirSetSwapped(pte_dir_t *_pd, int _page_num, int _prot, int _slot);
+#endif // __PTE_H
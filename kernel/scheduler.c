@@ -6,24 +6,77 @@
 /*
  * Internal struct definitions
  */
-typedef struct node {
-    pcb_t *process;
-    struct node *next;
-    struct node *prev;
-} node_t;
+typedef struct scheduler scheduler_t;
+
+/*
+ * A scheduling policy decides which ready list a process goes on and which ready process runs
+ * next. The policy is chosen at boot (see SchedulerSetPolicy); round robin is the default.
+ * update_aging and promote are optional and may be NULL.
+ */
+typedef struct scheduler_policy {
+    char   *name;
+    int    (*add_ready)(scheduler_t *_scheduler, pcb_t *_process);
+    pcb_t *(*get_ready)(scheduler_t *_scheduler);
+    int    (*update_quantum)(scheduler_t *_scheduler, pcb_t *_process);
+    int    (*update_aging)(scheduler_t *_scheduler);
+    void   (*promote)(pcb_t *_process);
+} scheduler_policy_t;
 
 typedef struct scheduler {
-    node_t *lists[SCHEDULER_NUM_LISTS];
+    pcb_queue_t lists[SCHEDULER_NUM_LISTS];
+    pcb_queue_t pids[SCHEDULER_PID_BUCKETS];   // Master process table, hashed by pid and
+                                               // linked through hash_next/hash_prev instead
+    pcb_queue_t ready[SCHEDULER_NUM_PRIORITIES];   // Ready lists (only MLFQ uses more than one)
+    pcb_queue_t wheel[SCHEDULER_WHEEL_SIZE];
+    unsigned long ticks;        // Number of clock ticks seen so far (drives the delay wheel)
+    unsigned long pass;         // Stride: pass value of the most recently dispatched process
+    scheduler_policy_t *policy;
+    pcb_t      *running;
+    pcb_t      *idle;
 } scheduler_t;
 
 
 /*
  * Local Function Definitions
  */
-static int    SchedulerAdd(scheduler_t *_scheduler, pcb_t *_process, int _start, int _end);
-static pcb_t *SchedulerGet(scheduler_t *_scheduler, int _pid, int _start, int _end);
-static int    SchedulerPrint(scheduler_t *_scheduler, int _start);
-static int    SchedulerRemove(scheduler_t *_scheduler, int _pid, int _start, int _end);
+static int    SchedulerAdd(pcb_queue_t *_queue, pcb_t *_process);
+static pcb_t *SchedulerGet(scheduler_t *_scheduler, pcb_queue_t *_queue, int _pid);
+static int    SchedulerPrint(pcb_queue_t *_queue);
+static int    SchedulerRemove(scheduler_t *_scheduler, pcb_queue_t *_queue, int _pid);
+static void   SchedulerUnlink(pcb_t *_process);
+static int    SchedulerWake(scheduler_t *_scheduler, pcb_queue_t *_queue, int _pid);
+static void   SchedulerInsertAfter(pcb_queue_t *_queue, pcb_t *_prev, pcb_t *_process);
+static int    SchedulerIsReady(scheduler_t *_scheduler, pcb_t *_process);
+static int    SchedulerProcessAdd(scheduler_t *_scheduler, pcb_t *_process);
+static pcb_t *SchedulerProcessGet(scheduler_t *_scheduler, int _pid);
+static int    SchedulerProcessPrint(scheduler_t *_scheduler);
+static int    SchedulerProcessRemove(scheduler_t *_scheduler, int _pid);
+
+static int    SchedulerRRAddReady(scheduler_t *_scheduler, pcb_t *_process);
+static pcb_t *SchedulerRRGetReady(scheduler_t *_scheduler);
+static int    SchedulerRRUpdateQuantum(scheduler_t *_scheduler, pcb_t *_process);
+static int    SchedulerMLFQAddReady(scheduler_t *_scheduler, pcb_t *_process);
+static pcb_t *SchedulerMLFQGetReady(scheduler_t *_scheduler);
+static int    SchedulerMLFQUpdateQuantum(scheduler_t *_scheduler, pcb_t *_process);
+static int    SchedulerMLFQUpdateAging(scheduler_t *_scheduler);
+static void   SchedulerMLFQPromote(pcb_t *_process);
+static int    SchedulerStrideAddReady(scheduler_t *_scheduler, pcb_t *_process);
+static pcb_t *SchedulerStrideGetReady(scheduler_t *_scheduler);
+static int    SchedulerStrideUpdateQuantum(scheduler_t *_scheduler, pcb_t *_process);
+
+
+/*
+ * Available scheduling policies. The first entry is the default.
+ */
+static scheduler_policy_t s_policies[] = {
+    { "rr",     SchedulerRRAddReady,     SchedulerRRGetReady,
+                SchedulerRRUpdateQuantum,     NULL,                    NULL },
+    { "mlfq",   SchedulerMLFQAddReady,   SchedulerMLFQGetReady,
+                SchedulerMLFQUpdateQuantum,   SchedulerMLFQUpdateAging, SchedulerMLFQPromote },
+    { "stride", SchedulerStrideAddReady, SchedulerStrideGetReady,
+                SchedulerStrideUpdateQuantum, NULL,                    NULL },
+};
+#define SCHEDULER_NUM_POLICIES (sizeof(s_policies) / sizeof(s_policies[0]))
 
 
 /*!
@@ -39,34 +92,31 @@ scheduler_t *SchedulerCreate() {
         Halt();
     }
 
-    // 2. Initialize the list start and end pointers to NULL
+    // 2. Initialize the list start and end pointers to NULL. The lists are linked through the
+    //    pcbs themselves, so there is nothing else to allocate here (or on any later add).
     for (int i = 0; i < SCHEDULER_NUM_LISTS; i++) {
-        scheduler->lists[i] = NULL;
+        scheduler->lists[i].start = NULL;
+        scheduler->lists[i].end   = NULL;
     }
-
-    // 3. Go ahead and initialize a node for the running process since we will only ever need
-    //    one and we never delete the node. Set its internel pointers to NULL though.
-    node_t *running = (node_t *) malloc(sizeof(node_t));
-    if (!running) {
-        TracePrintf(1, "[SchedulerCreate] Error mallocing space for running node\n");
-        Halt();
+    for (int i = 0; i < SCHEDULER_PID_BUCKETS; i++) {
+        scheduler->pids[i].start = NULL;
+        scheduler->pids[i].end   = NULL;
     }
-    running->process = NULL;
-    running->next    = NULL;
-    running->prev    = NULL;
-    scheduler->lists[SCHEDULER_RUNNING] = running;
-
-    // 4. Go ahead and initialize a node for the idle process since we will only ever need
-    //    one and we never delete the node. Set its internel pointers to NULL though.
-    node_t *idle = (node_t *) malloc(sizeof(node_t));
-    if (!idle) {
-        TracePrintf(1, "[SchedulerCreate] Error mallocing space for idle node\n");
-        Halt();
+    for (int i = 0; i < SCHEDULER_NUM_PRIORITIES; i++) {
+        scheduler->ready[i].start = NULL;
+        scheduler->ready[i].end   = NULL;
+    }
+    for (int i = 0; i < SCHEDULER_WHEEL_SIZE; i++) {
+        scheduler->wheel[i].start = NULL;
+        scheduler->wheel[i].end   = NULL;
     }
-    idle->process = NULL;
-    idle->next    = NULL;
-    idle->prev    = NULL;
-    scheduler->lists[SCHEDULER_IDLE] = idle;
+    scheduler->ticks  = 0;
+    scheduler->pass   = 0;
+    scheduler->policy = &s_policies[0];
+
+    // 3. The running and idle "lists" only ever hold one process, so just keep a pointer to each.
+    scheduler->running = NULL;
+    scheduler->idle    = NULL;
     return scheduler;
 }
 
@@ -83,7 +133,7 @@ int SchedulerDelete(scheduler_t *_scheduler) {
         return ERROR;
     }
 
-    // 2. TODO: Loop over every list and free nodes. Then free scheduler struct
+    // 2. The lists are linked through the pcbs, so there are no nodes to free. Free the struct.
     free(_scheduler);
     return 0;
 }
@@ -94,26 +144,29 @@ int SchedulerDelete(scheduler_t *_scheduler) {
  *                        scheduler's internal lists. Most of these are thin wrappers that call
  *                        our internal add function. The Running, Init, and Idle lists, however,
  *                        behave differently since they are all "lists" of size 1. Thus, we simply
- *                        update the existing node's process pointer instead of calling add and
- *                        appending a completely new node.
+ *                        update the scheduler's pointer to that process instead of calling add.
+ *
+ *                        The lists are linked through the queue_next/queue_prev fields embedded
+ *                        in each pcb, so adding never allocates. A process may only be on one
+ *                        list at a time; adding a process that is already on one returns ERROR.
+ *
+ *                        Processes blocked on a cvar, lock, pipe, or terminal are added to the
+ *                        wait queue owned by that object (passed in as _queue) rather than to one
+ *                        of the scheduler's own lists.
  *
  * \param[in] _scheduler  An initialized scheduler_t struct
+ * \param[in] _queue      The wait queue of the object the process is blocking on
  * \param[in] _process    The PCB of the process the caller wishes to add to the specified list
- * \param[in] _start      The index of the specified list's start node (only used internally)
- * \param[in] _end        The index of the specified list's end node   (only used internally)
  * 
  * \return                0 on success, ERROR otherwise.
  */
-int SchedulerAddCVar(scheduler_t *_scheduler, pcb_t *_process) {
+int SchedulerAddCVar(scheduler_t *_scheduler, pcb_queue_t *_queue, pcb_t *_process) {
     // 1. Check arguments and return error if invalid. Otherwise, call internal add.
-    if (!_scheduler || !_process) {
-        TracePrintf(1, "[SchedulerAddCVar] Invalid list or process pointer\n");
+    if (!_scheduler || !_queue || !_process) {
+        TracePrintf(1, "[SchedulerAddCVar] Invalid list, queue, or process pointer\n");
         return ERROR;
     }
-    return SchedulerAdd(_scheduler,
-                       _process,
-                       SCHEDULER_CVAR_START,
-                       SCHEDULER_CVAR_END);
+    return SchedulerAdd(_queue, _process);
 }
 
 int SchedulerAddDelay(scheduler_t *_scheduler, pcb_t *_process) {
@@ -122,10 +175,26 @@ int SchedulerAddDelay(scheduler_t *_scheduler, pcb_t *_process) {
         TracePrintf(1, "[SchedulerAddDelay] Invalid list or process pointer\n");
         return ERROR;
     }
-    return SchedulerAdd(_scheduler,
-                       _process,
-                       SCHEDULER_DELAY_START,
-                       SCHEDULER_DELAY_END);
+    if (_process->queue) {
+        TracePrintf(1, "[SchedulerAddDelay] Process %d is already on a list\n", _process->pid);
+        return ERROR;
+    }
+
+    // 2. Delayed processes live on a hashed timing wheel. Work out the tick the process should
+    //    wake on and hash it into its slot. Each slot is kept sorted by wake tick, so that
+    //    SchedulerUpdateDelay can stop at the first process that is not due yet.
+    int clock_ticks = _process->clock_ticks > 0 ? _process->clock_ticks : 1;
+    _process->wake_tick = _scheduler->ticks + clock_ticks;
+    pcb_queue_t *slot   = &_scheduler->wheel[_process->wake_tick % SCHEDULER_WHEEL_SIZE];
+
+    // 3. Walk backwards from the end of the slot (new delays usually wake last) to find the
+    //    process we should be inserted after. If there is none, we go at the front.
+    pcb_t *prev = slot->end;
+    while (prev && prev->wake_tick > _process->wake_tick) {
+        prev = prev->queue_prev;
+    }
+    SchedulerInsertAfter(slot, prev, _process);
+    return 0;
 }
 
 int SchedulerAddIdle(scheduler_t *_scheduler, pcb_t *_process) {
@@ -134,56 +203,57 @@ int SchedulerAddIdle(scheduler_t *_scheduler, pcb_t *_process) {
         TracePrintf(1, "[SchedulerAddIdle] Invalid list or process pointer\n");
         return ERROR;
     }
-    _scheduler->lists[SCHEDULER_IDLE]->process = _process;
+    _scheduler->idle = _process;
     return 0;
 }
 
-int SchedulerAddLock(scheduler_t *_scheduler, pcb_t *_process) {
+int SchedulerAddLock(scheduler_t *_scheduler, pcb_queue_t *_queue, pcb_t *_process) {
     // 1. Check arguments and return error if invalid. Otherwise, call internal add.
-    if (!_scheduler || !_process) {
-        TracePrintf(1, "[SchedulerAddLock] Invalid list or process pointer\n");
+    if (!_scheduler || !_queue || !_process) {
+        TracePrintf(1, "[SchedulerAddLock] Invalid list, queue, or process pointer\n");
         return ERROR;
     }
-    return SchedulerAdd(_scheduler,
-                       _process,
-                       SCHEDULER_LOCK_START,
-                       SCHEDULER_LOCK_END);
+    return SchedulerAdd(_queue, _process);
 }
 
-int SchedulerAddPipeRead(scheduler_t *_scheduler, pcb_t *_process) {
+int SchedulerAddPipeRead(scheduler_t *_scheduler, pcb_queue_t *_queue, pcb_t *_process) {
     // 1. Check arguments and return error if invalid. Otherwise, call internal add.
-    if (!_scheduler || !_process) {
-        TracePrintf(1, "[SchedulerAddPipeRead] Invalid list or process pointer\n");
+    if (!_scheduler || !_queue || !_process) {
+        TracePrintf(1, "[SchedulerAddPipeRead] Invalid list, queue, or process pointer\n");
         return ERROR;
     }
-    return SchedulerAdd(_scheduler,
-                       _process,
-                       SCHEDULER_PIPE_READ_START,
-                       SCHEDULER_PIPE_READ_END);
+
+    // 2. A process that blocks waiting for input is likely interactive, so bump its priority
+    //    up a level before it goes to sleep so that it runs promptly once the input arrives
+    //    (if the scheduling policy uses priorities).
+    if (_scheduler->policy->promote) {
+        _scheduler->policy->promote(_process);
+    }
+    return SchedulerAdd(_queue, _process);
 }
 
-int SchedulerAddPipeWrite(scheduler_t *_scheduler, pcb_t *_process) {
+int SchedulerAddPipeWrite(scheduler_t *_scheduler, pcb_queue_t *_queue, pcb_t *_process) {
     // 1. Check arguments and return error if invalid. Otherwise, call internal add.
-    if (!_scheduler || !_process) {
-        TracePrintf(1, "[SchedulerAddPipeWrite] Invalid list or process pointer\n");
+    if (!_scheduler || !_queue || !_process) {
+        TracePrintf(1, "[SchedulerAddPipeWrite] Invalid list, queue, or process pointer\n");
         return ERROR;
     }
-    return SchedulerAdd(_scheduler,
-                       _process,
-                       SCHEDULER_PIPE_WRITE_START,
-                       SCHEDULER_PIPE_WRITE_END);
+    return SchedulerAdd(_queue, _process);
 }
 
 int SchedulerAddProcess(scheduler_t *_scheduler, pcb_t *_process) {
-    // 1. Check arguments and return error if invalid. Otherwise, call internal add.
+    // 1. Check arguments and return error if invalid.
     if (!_scheduler || !_process) {
         TracePrintf(1, "[SchedulerAddProcess] Invalid list or process pointer\n");
         return ERROR;
     }
-    return SchedulerAdd(_scheduler,
-                       _process,
-                       SCHEDULER_PROCESSES_START,
-                       SCHEDULER_PROCESSES_END);
+
+    // 2. Give the process the default number of stride tickets if it does not have any yet
+    //    (fork then gives a child the same tickets as its parent), then call internal add.
+    if (!_process->tickets) {
+        SchedulerSetTickets(_scheduler, _process, SCHEDULER_DEFAULT_TICKETS);
+    }
+    return SchedulerProcessAdd(_scheduler, _process);
 }
 
 int SchedulerAddReady(scheduler_t *_scheduler, pcb_t *_process) {
@@ -197,10 +267,13 @@ int SchedulerAddReady(scheduler_t *_scheduler, pcb_t *_process) {
     if (_process == SchedulerGetIdle(_scheduler)) {
         return 0;
     }
-    return SchedulerAdd(_scheduler,
-                       _process,
-                       SCHEDULER_READY_START,
-                       SCHEDULER_READY_END);
+
+    // 3. Otherwise, let the scheduling policy decide where on the ready lists it should go.
+    if (_process->queue) {
+        TracePrintf(1, "[SchedulerAddReady] Process %d is already on a list\n", _process->pid);
+        return ERROR;
+    }
+    return _scheduler->policy->add_ready(_scheduler, _process);
 }
 
 int SchedulerAddRunning(scheduler_t *_scheduler, pcb_t *_process) {
@@ -209,44 +282,60 @@ int SchedulerAddRunning(scheduler_t *_scheduler, pcb_t *_process) {
         TracePrintf(1, "[SchedulerAddRunning] Invalid list or process pointer\n");
         return ERROR;
     }
-    _scheduler->lists[SCHEDULER_RUNNING]->process = _process;
+    _scheduler->running = _process;
     return 0;
 }
 
+int SchedulerAddSwap(scheduler_t *_scheduler, pcb_queue_t *_queue, pcb_t *_process) {
+    // 1. Check arguments and return error if invalid. Otherwise, call internal add.
+    if (!_scheduler || !_queue || !_process) {
+        TracePrintf(1, "[SchedulerAddSwap] Invalid list, queue, or process pointer\n");
+        return ERROR;
+    }
+    return SchedulerAdd(_queue, _process);
+}
+
 int SchedulerAddTerminated(scheduler_t *_scheduler, pcb_t *_process) {
     // 1. Check arguments and return error if invalid. Otherwise, call internal add.
     if (!_scheduler || !_process) {
         TracePrintf(1, "[SchedulerAddTerminated] Invalid list or process pointer\n");
         return ERROR;
     }
-    return SchedulerAdd(_scheduler,
-                       _process,
-                       SCHEDULER_TERMINATED_START,
-                       SCHEDULER_TERMINATED_END);
+    return SchedulerAdd(&_scheduler->lists[SCHEDULER_TERMINATED], _process);
 }
 
-int SchedulerAddTTYRead(scheduler_t *_scheduler, pcb_t *_process) {
+int SchedulerAddTTYRead(scheduler_t *_scheduler, pcb_queue_t *_queue, pcb_t *_process) {
     // 1. Check arguments and return error if invalid. Otherwise, call internal add.
-    if (!_scheduler || !_process) {
-        TracePrintf(1, "[SchedulerAddTTYRead] Invalid list or process pointer\n");
+    if (!_scheduler || !_queue || !_process) {
+        TracePrintf(1, "[SchedulerAddTTYRead] Invalid list, queue, or process pointer\n");
         return ERROR;
     }
-    return SchedulerAdd(_scheduler,
-                       _process,
-                       SCHEDULER_TTY_READ_START,
-                       SCHEDULER_TTY_READ_END);
+
+    // 2. A process that blocks waiting for input is likely interactive, so bump its priority
+    //    up a level before it goes to sleep so that it runs promptly once the input arrives
+    //    (if the scheduling policy uses priorities).
+    if (_scheduler->policy->promote) {
+        _scheduler->policy->promote(_process);
+    }
+    return SchedulerAdd(_queue, _process);
 }
 
-int SchedulerAddTTYWrite(scheduler_t *_scheduler, pcb_t *_process) {
+int SchedulerAddTTYWrite(scheduler_t *_scheduler, pcb_queue_t *_queue, pcb_t *_process) {
     // 1. Check arguments and return error if invalid. Otherwise, call internal add.
-    if (!_scheduler || !_process) {
-        TracePrintf(1, "[SchedulerAddTTYWrite] Invalid list or process pointer\n");
+    if (!_scheduler || !_queue || !_process) {
+        TracePrintf(1, "[SchedulerAddTTYWrite] Invalid list, queue, or process pointer\n");
+        return ERROR;
+    }
+    return SchedulerAdd(_queue, _process);
+}
+
+int SchedulerAddVfork(scheduler_t *_scheduler, pcb_queue_t *_queue, pcb_t *_process) {
+    // 1. Check arguments and return error if invalid. Otherwise, call internal add.
+    if (!_scheduler || !_queue || !_process) {
+        TracePrintf(1, "[SchedulerAddVfork] Invalid list, queue, or process pointer\n");
         return ERROR;
     }
-    return SchedulerAdd(_scheduler,
-                       _process,
-                       SCHEDULER_TTY_WRITE_START,
-                       SCHEDULER_TTY_WRITE_END);
+    return SchedulerAdd(_queue, _process);
 }
 
 int SchedulerAddWait(scheduler_t *_scheduler, pcb_t *_process) {
@@ -255,41 +344,51 @@ int SchedulerAddWait(scheduler_t *_scheduler, pcb_t *_process) {
         TracePrintf(1, "[SchedulerAddWait] Invalid list or process pointer\n");
         return ERROR;
     }
-    return SchedulerAdd(_scheduler,
-                       _process,
-                       SCHEDULER_WAIT_START,
-                       SCHEDULER_WAIT_END);
+    return SchedulerAdd(&_scheduler->lists[SCHEDULER_WAIT], _process);
 }
 
-static int SchedulerAdd(scheduler_t *_scheduler, pcb_t *_process, int _start, int _end) {
-    // 1.
-    node_t *node = (node_t *) malloc(sizeof(node_t));
-    if (!node) {
-        TracePrintf(1, "[SchedulerAdd] Unable to malloc memory for node\n");
-        Halt();
+static int SchedulerAdd(pcb_queue_t *_queue, pcb_t *_process) {
+    // 1. Make sure the process is not already sitting on one of our lists. Since the links live
+    //    in the pcb itself, adding it a second time would corrupt whichever list it is on.
+    if (_process->queue) {
+        TracePrintf(1, "[SchedulerAdd] Process %d is already on a list\n", _process->pid);
+        return ERROR;
     }
-    node->process = _process;
+    pcb_queue_t *queue   = _queue;
+    _process->queue      = queue;
+    _process->queue_next = NULL;
 
-    // 2. First check for our base case: the blocked list is currently empty. If so,
-    //    add the current process (both as the start and end) to the blocked list.
-    //    Set the process' next and previous pointers to NULL. Return success.
-    if (!_scheduler->lists[_start]) {
-        _scheduler->lists[_start] = node;
-        _scheduler->lists[_end]   = node;
-        node->next = NULL;
-        node->prev = NULL;
+    // 2. First check for our base case: the list is currently empty. If so, add the
+    //    process as both the start and end of the list. Return success.
+    if (!queue->start) {
+        _process->queue_prev = NULL;
+        queue->start         = _process;
+        queue->end           = _process;
         return 0;
     }
 
-    // 3. Our blocked list is not empty. Our list is doubly linked, so we need to set the
-    //    current end to point to our new process as its "next" and our current process to
-    //    point to our current end as its "prev". Then, set the new process "next" to NULL
-    //    since it is the end of the list and update our end-of-list pointer in the list struct.
-    node_t *old_end         = _scheduler->lists[_end];
-    old_end->next           = node;
-    node->prev              = old_end;
-    node->next              = NULL;
-    _scheduler->lists[_end] = node;
+    // 3. Our list is not empty. Our list is doubly linked, so we need to set the current end
+    //    to point to our new process as its "next" and our new process to point to the current
+    //    end as its "prev". Then update our end-of-list pointer.
+    _process->queue_prev       = queue->end;
+    queue->end->queue_next     = _process;
+    queue->end                 = _process;
+    return 0;
+}
+
+static int SchedulerProcessAdd(scheduler_t *_scheduler, pcb_t *_process) {
+    // 1. Same as SchedulerAdd, but for the master process table which has its own set of links
+    //    (a process is in the table *and* on at most one of the other lists at a time). The
+    //    table is hashed by pid, so we add the process to the end of its pid's bucket.
+    pcb_queue_t *bucket = &_scheduler->pids[_process->pid % SCHEDULER_PID_BUCKETS];
+    _process->hash_next = NULL;
+    _process->hash_prev = bucket->end;
+    if (!bucket->start) {
+        bucket->start = _process;
+    } else {
+        bucket->end->hash_next = _process;
+    }
+    bucket->end = _process;
     return 0;
 }
 
@@ -305,14 +404,14 @@ static int SchedulerAdd(scheduler_t *_scheduler, pcb_t *_process, int _start, in
  *                        GetIdle, GetInit, and GetRunning return the one (and only) pcb in their
  *                        respective "list".
  * 
- *                        All of the other "getter" functions will loop over their specified list
- *                        and return the pcb associated with the given pid (if the pcb is in the
- *                        list). Unlike GetReady, these getters do not modify their lists.
+ *                        All of the other "getter" functions look the pid up in the scheduler's
+ *                        pid-hashed process table and return its pcb if the process is currently
+ *                        on the specified list, which takes constant time regardless of the list's
+ *                        length. Unlike GetReady, these getters do not modify their lists.
  *
  * \param[in] _scheduler  An initialized scheduler_t struct
  * \param[in] _pid        The pid of the process the caller wishes to retrieve from the specified list
- * \param[in] _start      The index of the specified list's start node (only used internally)
- * \param[in] _end        The index of the specified list's end node   (only used internally)
+ * \param[in] _queue      The list to operate on (only used internally)
  * 
  * \return                PCB of the process associated with pid on success, NULL otherwise.
  */
@@ -322,7 +421,23 @@ pcb_t *SchedulerGetIdle(scheduler_t *_scheduler) {
         TracePrintf(1, "[SchedulerGetIdle] Invalid list pointer\n");
         return NULL;
     }
-    return _scheduler->lists[SCHEDULER_IDLE]->process;
+    return _scheduler->idle;
+}
+
+/*!
+ * \desc                  Returns the number of clock ticks the scheduler has seen so far.
+ *
+ * \param[in] _scheduler  An initialized scheduler_t struct
+ *
+ * \return                The current tick on success, 0 otherwise.
+ */
+unsigned long SchedulerGetTicks(scheduler_t *_scheduler) {
+    // 1. Check arguments. Return error if invalid.
+    if (!_scheduler) {
+        TracePrintf(1, "[SchedulerGetTicks] Invalid list pointer\n");
+        return 0;
+    }
+    return _scheduler->ticks;
 }
 
 pcb_t *SchedulerGetProcess(scheduler_t *_scheduler, int _pid) {
@@ -331,10 +446,7 @@ pcb_t *SchedulerGetProcess(scheduler_t *_scheduler, int _pid) {
         TracePrintf(1, "[SchedulerGetProcess] Invalid list or pid\n");
         return NULL;
     }
-    return SchedulerGet(_scheduler,
-                       _pid,
-                       SCHEDULER_PROCESSES_START,
-                       SCHEDULER_PROCESSES_END);
+    return SchedulerProcessGet(_scheduler, _pid);
 }
 
 pcb_t *SchedulerGetReady(scheduler_t *_scheduler) {
@@ -344,29 +456,30 @@ pcb_t *SchedulerGetReady(scheduler_t *_scheduler) {
         return NULL;
     }
 
-    // 2. Check to see that we actually have processes in our ready list. If not, return NULL
-    if (!_scheduler->lists[SCHEDULER_READY_START]) {
+    // 2. Ask the scheduling policy for the next process to run. If there are no processes in
+    //    any of our ready lists, return idle.
+    pcb_t *process = _scheduler->policy->get_ready(_scheduler);
+    if (!process) {
         return SchedulerGetIdle(_scheduler);
     }
+    return process;
+}
 
-    // 3. Check for our base case: there is only 1 process in the ready list.
-    //    If so, set the list start and end pointers to NULL and return the process.
-    node_t *node    = _scheduler->lists[SCHEDULER_READY_START];
-    pcb_t  *process = node->process;
-    if (node == _scheduler->lists[SCHEDULER_READY_END]) {
-        _scheduler->lists[SCHEDULER_READY_START] = NULL;
-        _scheduler->lists[SCHEDULER_READY_END]   = NULL;
-        free(node);
-        return process;
+int SchedulerHasReady(scheduler_t *_scheduler) {
+    // 1. Check arguments. Return error if invalid.
+    if (!_scheduler) {
+        TracePrintf(1, "[SchedulerHasReady] Invalid list\n");
+        return ERROR;
     }
 
-    // 4. Otherwise, update the start of the list to point to the new head (i.e., proc's
-    //    next pointer). Then, clear the new head's prev pointer so it no longer points to
-    //    proc and clear proc's next pointer so it no longer points to the new head.
-    _scheduler->lists[SCHEDULER_READY_START]       = node->next;
-    _scheduler->lists[SCHEDULER_READY_START]->prev = NULL;
-    free(node);
-    return process;
+    // 2. Every policy keeps its ready processes on our ready lists, so simply check whether any
+    //    of them are non-empty. Idle is never on a ready list, so it does not count.
+    for (int i = 0; i < SCHEDULER_NUM_PRIORITIES; i++) {
+        if (_scheduler->ready[i].start) {
+            return 1;
+        }
+    }
+    return 0;
 }
 
 pcb_t *SchedulerGetRunning(scheduler_t *_scheduler) {
@@ -375,7 +488,7 @@ pcb_t *SchedulerGetRunning(scheduler_t *_scheduler) {
         TracePrintf(1, "[SchedulerGetRunning] Invalid list pointer\n");
         return NULL;
     }
-    return _scheduler->lists[SCHEDULER_RUNNING]->process;
+    return _scheduler->running;
 }
 
 pcb_t *SchedulerGetTerminated(scheduler_t *_scheduler, int _pid) {
@@ -384,24 +497,7 @@ pcb_t *SchedulerGetTerminated(scheduler_t *_scheduler, int _pid) {
         TracePrintf(1, "[SchedulerGetTerminated] Invalid list or pid\n");
         return NULL;
     }
-    return SchedulerGet(_scheduler,
-                       _pid,
-                       SCHEDULER_TERMINATED_START,
-                       SCHEDULER_TERMINATED_END);
-}
-
-pcb_t *SchedulerGetTTYWrite(scheduler_t *_scheduler) {
-    // 1. Check arguments and return error if invalid. Otherwise, call internal get.
-    if (!_scheduler) {
-        TracePrintf(1, "[SchedulerGetTTYWrite] Invalid list or pid\n");
-        return NULL;
-    }
-
-    if(_scheduler->lists[SCHEDULER_TTY_WRITE_START]) {
-        return _scheduler->lists[SCHEDULER_TTY_WRITE_START]->process;
-    } else {
-        return NULL;
-    }
+    return SchedulerGet(_scheduler, &_scheduler->lists[SCHEDULER_TERMINATED], _pid);
 }
 
 pcb_t *SchedulerGetWait(scheduler_t *_scheduler, int _pid) {
@@ -410,21 +506,28 @@ pcb_t *SchedulerGetWait(scheduler_t *_scheduler, int _pid) {
         TracePrintf(1, "[SchedulerGetWait] Invalid list or pid\n");
         return NULL;
     }
-    return SchedulerGet(_scheduler,
-                       _pid,
-                       SCHEDULER_WAIT_START,
-                       SCHEDULER_WAIT_END);
+    return SchedulerGet(_scheduler, &_scheduler->lists[SCHEDULER_WAIT], _pid);
 }
 
-static pcb_t *SchedulerGet(scheduler_t *_scheduler, int _pid, int _start, int _end) {
-    // 1. Loop over the terminated list in search of the process specified by _pid.
-    //    If found, return the pointer to the processes pcb_t struct.
-    node_t *node = _scheduler->lists[_start];
-    while (node) {
-        if (node->process->pid == _pid) {
-            return node->process;
+static pcb_t *SchedulerGet(scheduler_t *_scheduler, pcb_queue_t *_queue, int _pid) {
+    // 1. Look up the process specified by _pid in the process table. If found, and it is
+    //    currently on the specified list, return the pointer to the processes pcb_t struct.
+    pcb_t *process = SchedulerProcessGet(_scheduler, _pid);
+    if (process && process->queue == _queue) {
+        return process;
+    }
+    return NULL;
+}
+
+static pcb_t *SchedulerProcessGet(scheduler_t *_scheduler, int _pid) {
+    // 1. Loop over the pid's bucket in the process table in search of the process specified by
+    //    _pid. Pids are handed out sequentially, so buckets rarely hold more than one process.
+    pcb_t *process = _scheduler->pids[_pid % SCHEDULER_PID_BUCKETS].start;
+    while (process) {
+        if (process->pid == _pid) {
+            return process;
         }
-        node = node->next;
+        process = process->hash_next;
     }
     return NULL;
 }
@@ -435,20 +538,10 @@ static pcb_t *SchedulerGet(scheduler_t *_scheduler, int _pid, int _start, int _e
  *                        the pids of the processes contained within.
  *
  * \param[in] _scheduler  An initialized scheduler_t struct
- * \param[in] _start      The index of the specified list's start node (only used internally)
+ * \param[in] _queue      The list to operate on (only used internally)
  * 
  * \return                0 on success, ERROR otherwise.
  */
-int SchedulerPrintCVar(scheduler_t *_scheduler) {
-    // 1. Check arguments and return error if invalid. Otherwise, call internal print.
-    if (!_scheduler) {
-        TracePrintf(1, "[SchedulerPrintCVar] Invalid list pointer\n");
-        return ERROR;
-    }
-    TracePrintf(1, "[SchedulerPrintCVar] CVar List:\n");
-    return SchedulerPrint(_scheduler, SCHEDULER_CVAR_START);
-}
-
 int SchedulerPrintDelay(scheduler_t *_scheduler) {
     // 1. Check arguments and return error if invalid. Otherwise, call internal print.
     if (!_scheduler) {
@@ -456,37 +549,10 @@ int SchedulerPrintDelay(scheduler_t *_scheduler) {
         return ERROR;
     }
     TracePrintf(1, "[SchedulerPrintDelay] Delay List:\n");
-    return SchedulerPrint(_scheduler, SCHEDULER_DELAY_START);
-}
-
-int SchedulerPrintLock(scheduler_t *_scheduler) {
-    // 1. Check arguments and return error if invalid. Otherwise, call internal print.
-    if (!_scheduler) {
-        TracePrintf(1, "[SchedulerPrintLock] Invalid list pointer\n");
-        return ERROR;
-    }
-    TracePrintf(1, "[SchedulerPrintLock] Lock List:\n");
-    return SchedulerPrint(_scheduler, SCHEDULER_LOCK_START);
-}
-
-int SchedulerPrintPipeRead(scheduler_t *_scheduler) {
-    // 1. Check arguments and return error if invalid. Otherwise, call internal print.
-    if (!_scheduler) {
-        TracePrintf(1, "[SchedulerPrintPipeRead] Invalid list pointer\n");
-        return ERROR;
-    }
-    TracePrintf(1, "[SchedulerPrintPipeRead] Pipe Read List:\n");
-    return SchedulerPrint(_scheduler, SCHEDULER_PIPE_READ_START);
-}
-
-int SchedulerPrintPipeWrite(scheduler_t *_scheduler) {
-    // 1. Check arguments and return error if invalid. Otherwise, call internal print.
-    if (!_scheduler) {
-        TracePrintf(1, "[SchedulerPrintPipeWrite] Invalid list pointer\n");
-        return ERROR;
+    for (int i = 0; i < SCHEDULER_WHEEL_SIZE; i++) {
+        SchedulerPrint(&_scheduler->wheel[i]);
     }
-    TracePrintf(1, "[SchedulerPrintPipeWrite] Pipe Write List:\n");
-    return SchedulerPrint(_scheduler, SCHEDULER_PIPE_WRITE_START);
+    return 0;
 }
 
 int SchedulerPrintProcess(scheduler_t *_scheduler) {
@@ -496,7 +562,7 @@ int SchedulerPrintProcess(scheduler_t *_scheduler) {
         return ERROR;
     }
     TracePrintf(1, "[SchedulerPrintProcess] Process List:\n");
-    return SchedulerPrint(_scheduler, SCHEDULER_PROCESSES_START);
+    return SchedulerProcessPrint(_scheduler);
 }
 
 int SchedulerPrintReady(scheduler_t *_scheduler) {
@@ -505,8 +571,11 @@ int SchedulerPrintReady(scheduler_t *_scheduler) {
         TracePrintf(1, "[SchedulerPrintReady] Invalid list pointer\n");
         return ERROR;
     }
-    TracePrintf(1, "[SchedulerPrintReady] Ready List:\n");
-    return SchedulerPrint(_scheduler, SCHEDULER_READY_START);
+    for (int i = 0; i < SCHEDULER_NUM_PRIORITIES; i++) {
+        TracePrintf(1, "[SchedulerPrintReady] Ready List (priority %d):\n", i);
+        SchedulerPrint(&_scheduler->ready[i]);
+    }
+    return 0;
 }
 
 int SchedulerPrintTerminated(scheduler_t *_scheduler) {
@@ -516,27 +585,7 @@ int SchedulerPrintTerminated(scheduler_t *_scheduler) {
         return ERROR;
     }
     TracePrintf(1, "[SchedulerPrintTerminated] Terminated List:\n");
-    return SchedulerPrint(_scheduler, SCHEDULER_TERMINATED_START);
-}
-
-int SchedulerPrintTTYRead(scheduler_t *_scheduler) {
-    // 1. Check arguments and return error if invalid. Otherwise, call internal print.
-    if (!_scheduler) {
-        TracePrintf(1, "[SchedulerPrintTTYRead] Invalid list pointer\n");
-        return ERROR;
-    }
-    TracePrintf(1, "[SchedulerPrintTTYRead] TTYRead List:\n");
-    return SchedulerPrint(_scheduler, SCHEDULER_TTY_READ_START);
-}
-
-int SchedulerPrintTTYWrite(scheduler_t *_scheduler) {
-    // 1. Check arguments and return error if invalid. Otherwise, call internal print.
-    if (!_scheduler) {
-        TracePrintf(1, "[SchedulerPrintTTYWrite] Invalid list pointer\n");
-        return ERROR;
-    }
-    TracePrintf(1, "[SchedulerPrintTTYWrite] TTYWrite List:\n");
-    return SchedulerPrint(_scheduler, SCHEDULER_TTY_WRITE_START);
+    return SchedulerPrint(&_scheduler->lists[SCHEDULER_TERMINATED]);
 }
 
 int SchedulerPrintWait(scheduler_t *_scheduler) {
@@ -546,14 +595,25 @@ int SchedulerPrintWait(scheduler_t *_scheduler) {
         return ERROR;
     }
     TracePrintf(1, "[SchedulerPrintWait] Wait List:\n");
-    return SchedulerPrint(_scheduler, SCHEDULER_WAIT_START);
+    return SchedulerPrint(&_scheduler->lists[SCHEDULER_WAIT]);
 }
 
-static int SchedulerPrint(scheduler_t *_scheduler, int _start) {
-    node_t *node = _scheduler->lists[_start];
-    while (node) {
-        TracePrintf(1, "\tpid: %d\n", node->process->pid);
-        node = node->next;
+static int SchedulerPrint(pcb_queue_t *_queue) {
+    pcb_t *process = _queue->start;
+    while (process) {
+        TracePrintf(1, "\tpid: %d\n", process->pid);
+        process = process->queue_next;
+    }
+    return 0;
+}
+
+static int SchedulerProcessPrint(scheduler_t *_scheduler) {
+    for (int i = 0; i < SCHEDULER_PID_BUCKETS; i++) {
+        pcb_t *process = _scheduler->pids[i].start;
+        while (process) {
+            TracePrintf(1, "\tpid: %d\n", process->pid);
+            process = process->hash_next;
+        }
     }
     return 0;
 }
@@ -567,69 +627,24 @@ static int SchedulerPrint(scheduler_t *_scheduler, int _start) {
  *
  * \param[in] _scheduler  An initialized scheduler_t struct
  * \param[in] _pid        The pid of the process the caller wishes to remove from the specified list
- * \param[in] _start      The index of the specified list's start node (only used internally)
- * \param[in] _end        The index of the specified list's end node   (only used internally)
+ * \param[in] _queue      The list to operate on (only used internally)
  * 
  * \return                0 on success, ERROR otherwise.
  */
-int SchedulerRemoveCVar(scheduler_t *_scheduler, int _pid) {
-    // 1. Check arguments and return error if invalid. Otherwise, call internal remove.
-    if (!_scheduler || _pid < 0) {
-        TracePrintf(1, "[SchedulerRemoveCVar] Invalid list or pid\n");
-        return ERROR;
-    }
-    return SchedulerRemove(_scheduler,
-                          _pid,
-                          SCHEDULER_CVAR_START,
-                          SCHEDULER_CVAR_END);
-}
-
 int SchedulerRemoveDelay(scheduler_t *_scheduler, int _pid) {
     // 1. Check arguments and return error if invalid. Otherwise, call internal remove.
     if (!_scheduler || _pid < 0) {
         TracePrintf(1, "[SchedulerRemoveDelay] Invalid list or pid\n");
         return ERROR;
     }
-    return SchedulerRemove(_scheduler,
-                          _pid,
-                          SCHEDULER_DELAY_START,
-                          SCHEDULER_DELAY_END);
-}
-
-int SchedulerRemoveLock(scheduler_t *_scheduler, int _pid) {
-    // 1. Check arguments and return error if invalid. Otherwise, call internal remove.
-    if (!_scheduler || _pid < 0) {
-        TracePrintf(1, "[SchedulerRemoveLock] Invalid list or pid\n");
-        return ERROR;
-    }
-    return SchedulerRemove(_scheduler,
-                          _pid,
-                          SCHEDULER_LOCK_START,
-                          SCHEDULER_LOCK_END);
-}
-
-int SchedulerRemovePipeRead(scheduler_t *_scheduler, int _pid) {
-    // 1. Check arguments and return error if invalid. Otherwise, call internal remove.
-    if (!_scheduler || _pid < 0) {
-        TracePrintf(1, "[SchedulerRemovePipeRead] Invalid list or pid\n");
-        return ERROR;
-    }
-    return SchedulerRemove(_scheduler,
-                          _pid,
-                          SCHEDULER_PIPE_READ_START,
-                          SCHEDULER_PIPE_READ_END);
-}
 
-int SchedulerRemovePipeWrite(scheduler_t *_scheduler, int _pid) {
-    // 1. Check arguments and return error if invalid. Otherwise, call internal remove.
-    if (!_scheduler || _pid < 0) {
-        TracePrintf(1, "[SchedulerRemovePipeWrite] Invalid list or pid\n");
+    // 2. A delayed process sits in the wheel slot for its wake tick, so look that up first.
+    pcb_t *process = SchedulerProcessGet(_scheduler, _pid);
+    if (!process) {
+        TracePrintf(1, "[SchedulerRemoveDelay] Process %d not found\n", _pid);
         return ERROR;
     }
-    return SchedulerRemove(_scheduler,
-                          _pid,
-                          SCHEDULER_PIPE_WRITE_START,
-                          SCHEDULER_PIPE_WRITE_END);
+    return SchedulerRemove(_scheduler, &_scheduler->wheel[process->wake_tick % SCHEDULER_WHEEL_SIZE], _pid);
 }
 
 int SchedulerRemoveProcess(scheduler_t *_scheduler, int _pid) {
@@ -638,10 +653,7 @@ int SchedulerRemoveProcess(scheduler_t *_scheduler, int _pid) {
         TracePrintf(1, "[SchedulerRemoveProcess] Invalid list or pid\n");
         return ERROR;
     }
-    return SchedulerRemove(_scheduler,
-                          _pid,
-                          SCHEDULER_PROCESSES_START,
-                          SCHEDULER_PROCESSES_END);
+    return SchedulerProcessRemove(_scheduler, _pid);
 }
 
 int SchedulerRemoveReady(scheduler_t *_scheduler, int _pid) {
@@ -650,10 +662,13 @@ int SchedulerRemoveReady(scheduler_t *_scheduler, int _pid) {
         TracePrintf(1, "[SchedulerRemoveReady] Invalid list or pid\n");
         return ERROR;
     }
-    return SchedulerRemove(_scheduler,
-                          _pid,
-                          SCHEDULER_READY_START,
-                          SCHEDULER_READY_END);
+    pcb_t *process = SchedulerProcessGet(_scheduler, _pid);
+    if (!process || !SchedulerIsReady(_scheduler, process)) {
+        TracePrintf(1, "[SchedulerRemoveReady] Process %d not found\n", _pid);
+        return ERROR;
+    }
+    SchedulerUnlink(process);
+    return 0;
 }
 
 int SchedulerRemoveTerminated(scheduler_t *_scheduler, int _pid) {
@@ -662,137 +677,137 @@ int SchedulerRemoveTerminated(scheduler_t *_scheduler, int _pid) {
         TracePrintf(1, "[SchedulerRemoveTerminated] Invalid list or pid\n");
         return ERROR;
     }
-    return SchedulerRemove(_scheduler,
-                          _pid,
-                          SCHEDULER_TERMINATED_START,
-                          SCHEDULER_TERMINATED_END);
+    return SchedulerRemove(_scheduler, &_scheduler->lists[SCHEDULER_TERMINATED], _pid);
 }
 
-int SchedulerRemoveTTYRead(scheduler_t *_scheduler, int _pid) {
+int SchedulerRemoveWait(scheduler_t *_scheduler, int _pid) {
     // 1. Check arguments and return error if invalid. Otherwise, call internal remove.
     if (!_scheduler || _pid < 0) {
-        TracePrintf(1, "[SchedulerRemoveTTYRead] Invalid list or pid\n");
+        TracePrintf(1, "[SchedulerRemoveWait] Invalid list or pid\n");
         return ERROR;
     }
-    return SchedulerRemove(_scheduler,
-                          _pid,
-                          SCHEDULER_TTY_READ_START,
-                          SCHEDULER_TTY_READ_END);
+    return SchedulerRemove(_scheduler, &_scheduler->lists[SCHEDULER_WAIT], _pid);
 }
 
-int SchedulerRemoveTTYWrite(scheduler_t *_scheduler, int _pid) {
-    // 1. Check arguments and return error if invalid. Otherwise, call internal remove.
-    if (!_scheduler || _pid < 0) {
-        TracePrintf(1, "[SchedulerRemoveTTYWrite] Invalid list or pid\n");
+static int SchedulerRemove(scheduler_t *_scheduler, pcb_queue_t *_queue, int _pid) {
+    // 1. Find the process on the specified list. Once we have its pcb, unlinking it is O(1).
+    pcb_t *process = SchedulerGet(_scheduler, _queue, _pid);
+    if (!process) {
+        TracePrintf(1, "[SchedulerRemove] Process %d not found\n", _pid);
         return ERROR;
     }
-    return SchedulerRemove(_scheduler,
-                          _pid,
-                          SCHEDULER_TTY_WRITE_START,
-                          SCHEDULER_TTY_WRITE_END);
+    SchedulerUnlink(process);
+    return 0;
 }
 
-int SchedulerRemoveWait(scheduler_t *_scheduler, int _pid) {
-    // 1. Check arguments and return error if invalid. Otherwise, call internal remove.
-    if (!_scheduler || _pid < 0) {
-        TracePrintf(1, "[SchedulerRemoveWait] Invalid list or pid\n");
-        return ERROR;
+static void SchedulerUnlink(pcb_t *_process) {
+    // 1. Nothing to do if the process is not on a list.
+    pcb_queue_t *queue = _process->queue;
+    if (!queue) {
+        return;
     }
-    return SchedulerRemove(_scheduler,
-                          _pid,
-                          SCHEDULER_WAIT_START,
-                          SCHEDULER_WAIT_END);
-}
 
-static int SchedulerRemove(scheduler_t *_scheduler, int _pid, int _start, int _end) {
-    // 1. First check for our base case: the terminated list is currently empty. If so,
-    //    add the current process (both as the start and end) to the terminated list.
-    //    Set the process' next and previous pointers to NULL. Return success.
-    if (!_scheduler->lists[_start]) {
-        TracePrintf(1, "[SchedulerRemove] List empty\n");
-        return ERROR;
+    // 2. Point our neighbors (or the list's start/end pointers if we are at either end of the
+    //    list) at each other. Then clear our own links so that the process can be added again.
+    if (_process->queue_prev) {
+        _process->queue_prev->queue_next = _process->queue_next;
+    } else {
+        queue->start = _process->queue_next;
     }
-
-    // 2. Check for our first base case: The process is at the start of the terminated list.
-    //    Set the new head of the list to the next terminated process pointed to by "proc".
-    //    Remove the next terminated processes previous reference to "proc" as it is no
-    //    longer in the list. Clear the next and prev pointers in "proc" for good measure.
-    //    NOTE: Make sure you check if next is NULL so you don't try to dereference it.
-    node_t *node = _scheduler->lists[_start];
-    if (node->process->pid == _pid) {
-        _scheduler->lists[_start] = node->next;
-        if (_scheduler->lists[_start]) {
-            _scheduler->lists[_start]->prev = NULL;
-        }
-        free(node);
-        return 0;
+    if (_process->queue_next) {
+        _process->queue_next->queue_prev = _process->queue_prev;
+    } else {
+        queue->end = _process->queue_prev;
     }
+    _process->queue_next = NULL;
+    _process->queue_prev = NULL;
+    _process->queue      = NULL;
+}
 
-    // 4. Check for our second base case: The process is at the end of the terminated list.
-    //    Set the new end of the list to the prev terminated process pointed to by "proc".
-    //    Remove the prev terminated processes next reference to "proc" as it is no longer
-    //    in the list. Clear the next and prev pointers in "proc" for good measure.
-    node = _scheduler->lists[_end];
-    if (node->process->pid == _pid) {
-        _scheduler->lists[_end]       = node->prev;
-        _scheduler->lists[_end]->next = NULL;
-        free(node);
-        return 0;
+static int SchedulerProcessRemove(scheduler_t *_scheduler, int _pid) {
+    // 1. Find the process in the process table, then unlink it from its bucket in the same way
+    //    as SchedulerUnlink.
+    pcb_t *process = SchedulerProcessGet(_scheduler, _pid);
+    if (!process) {
+        TracePrintf(1, "[SchedulerProcessRemove] Process %d not found\n", _pid);
+        return ERROR;
     }
-
-    // 5. If the process to remove is neither the first or last item in our terminated list, then
-    //    loop through the processes inbetween to locate it (starting from the second process
-    //    in the list). If you find the process, remove it from the list and return success.
-    node = _scheduler->lists[_start]->next;
-    while (node) {
-        if (node->process->pid == _pid) {
-            node->prev->next = node->next;
-            node->next->prev = node->prev;
-            free(node);
-            return 0;
-        }
-        node = node->next;
+    pcb_queue_t *bucket = &_scheduler->pids[_pid % SCHEDULER_PID_BUCKETS];
+    if (process->hash_prev) {
+        process->hash_prev->hash_next = process->hash_next;
+    } else {
+        bucket->start = process->hash_next;
     }
-
-    // 6. If we made it this far, then the process specified by _pid was not found. Return ERROR.
-    TracePrintf(1, "[SchedulerRemove] Process %d not found\n", _pid);
-    return ERROR;
+    if (process->hash_next) {
+        process->hash_next->hash_prev = process->hash_prev;
+    } else {
+        bucket->end = process->hash_prev;
+    }
+    process->hash_next = NULL;
+    process->hash_prev = NULL;
+    return 0;
 }
 
 
 /*!
  * \desc                  UPDATE FUNCTIONS - These functions are used to update the state of the
- *                        "blocked" lists (e.g., delay, lock, pipe, tty). They loop over the
- *                        specified list to check if any of the processes meet the necessary
- *                        conditions for being unblocked. If so, they are removed from the list
- *                        and added to the ready list (if applicable).
+ *                        "blocked" lists (e.g., delay, lock, pipe, tty). For cvars, locks, pipes,
+ *                        and terminals, each object owns its own FIFO wait queue, so waking the
+ *                        next waiter simply pops the front of that queue (or unlinks the specific
+ *                        pid the caller asked for). UpdateCVarAll drains the whole queue at once.
+ *                        Woken processes are removed from the queue and added to the ready list.
  *
  * \param[in] _scheduler  An initialized scheduler_t struct
+ * \param[in] _queue      The wait queue of the cvar, lock, pipe, or terminal to update
  * 
  * \return                0 on success, ERROR otherwise.
  */
-int SchedulerUpdateCVar(scheduler_t *_scheduler, int _cvar_id) {
+int SchedulerUpdateCVar(scheduler_t *_scheduler, pcb_queue_t *_queue) {
+    // 1. Check arguments. Return error if invalid.
+    if (!_scheduler || !_queue) {
+        TracePrintf(1, "[SchedulerUpdateCVar] Invalid list or queue pointer\n");
+        return ERROR;
+    }
+
+    // 2. Move the first (and only the first) process waiting on the cvar to the ready list.
+    //    Return ERROR if there was nobody waiting.
+    if (!SchedulerWake(_scheduler, _queue, 0)) {
+        return ERROR;
+    }
+    return 0;
+}
+
+int SchedulerUpdateCVarAll(scheduler_t *_scheduler, pcb_queue_t *_queue) {
+    // 1. Check arguments. Return error if invalid.
+    if (!_scheduler || !_queue) {
+        TracePrintf(1, "[SchedulerUpdateCVarAll] Invalid list or queue pointer\n");
+        return ERROR;
+    }
+
+    // 2. Drain the cvar's wait queue onto the ready list in a single pass (i.e., broadcast).
+    pcb_t *process = _queue->start;
+    while (process) {
+        pcb_t *next = process->queue_next;
+        TracePrintf(1, "[SchedulerUpdateCVarAll] Moving process: %d to ready\n", process->pid);
+        SchedulerUnlink(process);
+        SchedulerAddReady(_scheduler, process);
+        process = next;
+    }
+    return 0;
+}
+
+int SchedulerUpdateAging(scheduler_t *_scheduler) {
     // 1. Check arguments. Return error if invalid.
     if (!_scheduler) {
-        TracePrintf(1, "[SchedulerUpdateCVar] Invalid list pointer\n");
+        TracePrintf(1, "[SchedulerUpdateAging] Invalid list pointer\n");
         return ERROR;
     }
 
-    // 2. Loop over the Lock list to see if any processes are waiting to read from the pipe
-    //    specified by _pipe_id. If so, remove the first (and only the first) process waiting to
-    //    read and add it to the ready list.
-    node_t *node = _scheduler->lists[SCHEDULER_CVAR_START];
-    while (node) {
-        pcb_t *process = node->process;
-        if (process->cvar_id == _cvar_id) {
-            TracePrintf(1, "[SchedulerUpdateCVar] Moving process: %d to ready\n", process->pid);
-            SchedulerRemoveCVar(_scheduler, process->pid);
-            SchedulerAddReady(_scheduler, process);
-            return 0;
-        }
-        node = node->next;
+    // 2. Only policies with more than one priority level need to age their ready lists.
+    if (!_scheduler->policy->update_aging) {
+        return 0;
     }
-    return ERROR;
+    return _scheduler->policy->update_aging(_scheduler);
 }
 
 int SchedulerUpdateDelay(scheduler_t *_scheduler) {
@@ -802,125 +817,85 @@ int SchedulerUpdateDelay(scheduler_t *_scheduler) {
         return ERROR;
     }
 
-    // 2. Loop over the blocked list to check if any of the processes are blocked due to a delay
-    //    call. If so, decrement their clock_ticks value then check to see if it has reached 0.
-    //    If so, remove them from the blocked queue and add them to the ready queue.
-    node_t *node = _scheduler->lists[SCHEDULER_DELAY_START];
-    while (node) {
-        if (node->process->clock_ticks) {
-            node->process->clock_ticks--;
-            if (node->process->clock_ticks == 0) {
-                // TODO: Check these return values?
-                SchedulerRemove(_scheduler,
-                               node->process->pid,
-                               SCHEDULER_DELAY_START,
-                               SCHEDULER_DELAY_END);
-                SchedulerAdd(_scheduler,
-                            node->process,
-                            SCHEDULER_READY_START,
-                            SCHEDULER_READY_END);
-                TracePrintf(1, "[SchedulerUpdateDelay] Unblocked pid: %d\n", node->process->pid);
-            }
-        }
-        node = node->next;
+    // 2. Advance the clock and look at the one wheel slot for the current tick. Since each slot
+    //    is sorted by wake tick, every process at the front of the slot whose wake tick has come
+    //    is due; the first one that is not marks the start of the later laps around the wheel.
+    //    Processes in every other slot are not touched at all.
+    _scheduler->ticks++;
+    pcb_queue_t *slot = &_scheduler->wheel[_scheduler->ticks % SCHEDULER_WHEEL_SIZE];
+    pcb_t *process    = slot->start;
+    while (process && process->wake_tick <= _scheduler->ticks) {
+        pcb_t *next = process->queue_next;
+        process->clock_ticks = 0;
+        SchedulerUnlink(process);
+        SchedulerAddReady(_scheduler, process);
+        TracePrintf(1, "[SchedulerUpdateDelay] Unblocked pid: %d\n", process->pid);
+        process = next;
     }
     return 0;
 }
 
-int SchedulerUpdateLock(scheduler_t *_scheduler, int _lock_id) {
+int SchedulerUpdateQuantum(scheduler_t *_scheduler, pcb_t *_process) {
     // 1. Check arguments. Return error if invalid.
-    if (!_scheduler) {
-        TracePrintf(1, "[SchedulerUpdateLock] Invalid list pointer\n");
+    if (!_scheduler || !_process) {
+        TracePrintf(1, "[SchedulerUpdateQuantum] Invalid list or process pointer\n");
         return ERROR;
     }
 
-    // 2. Loop over the Lock list to see if any processes are waiting to read from the pipe
-    //    specified by _pipe_id. If so, remove the first (and only the first) process waiting to
-    //    read and add it to the ready list.
-    node_t *node = _scheduler->lists[SCHEDULER_LOCK_START];
-    while (node) {
-        pcb_t *process = node->process;
-        if (process->lock_id == _lock_id) {
-            TracePrintf(1, "[SchedulerUpdateLock] Moving process: %d to ready\n", process->pid);
-            SchedulerRemoveLock(_scheduler, process->pid);
-            SchedulerAddReady(_scheduler, process);
-            return 0;
-        }
-        node = node->next;
+    // 2. The idle process should always give up the cpu if there is anything else to run.
+    if (_process == SchedulerGetIdle(_scheduler)) {
+        return 1;
     }
-    return 0;
+
+    // 3. Otherwise, charge the process for the tick and let the policy decide whether it should
+    //    be preempted (1) or keep running (0).
+    return _scheduler->policy->update_quantum(_scheduler, _process);
 }
 
-int SchedulerUpdatePipeRead(scheduler_t *_scheduler, int _pipe_id, int _read_pid) {
+int SchedulerUpdateLock(scheduler_t *_scheduler, pcb_queue_t *_queue) {
     // 1. Check arguments. Return error if invalid.
-    if (!_scheduler) {
-        TracePrintf(1, "[SchedulerUpdatePipeRead] Invalid list pointer\n");
+    if (!_scheduler || !_queue) {
+        TracePrintf(1, "[SchedulerUpdateLock] Invalid list or queue pointer\n");
         return ERROR;
     }
 
-    // 2. Loop over the PipeRead list to see if any processes are waiting to read from the pipe
-    //    specified by _pipe_id. If so, remove the first (and only the first) process waiting to
-    //    read and add it to the ready list.
-    node_t *node = _scheduler->lists[SCHEDULER_PIPE_READ_START];
-    while (node) {
-        
-        // If read_pid = 0, then there is not currently a process reading from the pipe.
-        // So, we should just return the first process with a matching pipe_id
-        pcb_t *process = node->process;
-        if (process->pipe_id == _pipe_id && _read_pid == 0) {
-            TracePrintf(1, "[SchedulerUpdatePipeRead] Moving process: %d to ready\n", process->pid);
-            SchedulerRemovePipeRead(_scheduler, process->pid);
-            SchedulerAddReady(_scheduler, process);
-            return process->pid;
-        }
+    // 2. Move the first (and only the first) process waiting on the lock to the ready list.
+    SchedulerWake(_scheduler, _queue, 0);
+    return 0;
+}
 
-        // If read_pid is set, then we should only return the process with a matching pid
-        if (process->pid == _read_pid) {
-            TracePrintf(1, "[SchedulerUpdatePipeRead] Moving process: %d to ready\n", process->pid);
-            SchedulerRemovePipeRead(_scheduler, process->pid);
-            SchedulerAddReady(_scheduler, process);
-            return process->pid;
-        }
-        node = node->next;
+int SchedulerUpdatePipeRead(scheduler_t *_scheduler, pcb_queue_t *_queue) {
+    // 1. Check arguments. Return error if invalid.
+    if (!_scheduler || !_queue) {
+        TracePrintf(1, "[SchedulerUpdatePipeRead] Invalid list or queue pointer\n");
+        return ERROR;
     }
-    return 0;
+
+    // 2. Pipe readers are served in the order they arrive, so wake the first one in line.
+    return SchedulerWake(_scheduler, _queue, 0);
 }
 
-int SchedulerUpdatePipeWrite(scheduler_t *_scheduler, int _pipe_id, int _write_pid) {
+int SchedulerUpdatePipeWrite(scheduler_t *_scheduler, pcb_queue_t *_queue) {
     // 1. Check arguments. Return error if invalid.
-    if (!_scheduler) {
-        TracePrintf(1, "[SchedulerUpdatePipeWrite] Invalid list pointer\n");
+    if (!_scheduler || !_queue) {
+        TracePrintf(1, "[SchedulerUpdatePipeWrite] Invalid list or queue pointer\n");
         return ERROR;
     }
 
-    // 2. Loop over the PipeWrite list to see if any processes are waiting to write to the pipe
-    //    specified by _pipe_id. This differs slightly from UpdatePipeRead in that writes may
-    //    take multiple "rounds" if the user wishes to write more bytes than a pipe has space
-    //    for. Thus, we also need to check if there is currently a process writing to the
-    //    specified pipe (indicated by write_pid). If so, make sure we return that process.
-    node_t *node = _scheduler->lists[SCHEDULER_PIPE_WRITE_START];
-    while (node) {
-
-        // If write_pid = 0, then there is not currently a process writing to the pipe.
-        // So, we should just return the first process with a matching pipe_id
-        pcb_t *process = node->process;
-        if (process->pipe_id == _pipe_id && _write_pid == 0) {
-            TracePrintf(1, "[SchedulerUpdatePipeWrite] Moving process: %d to ready\n", process->pid);
-            SchedulerRemovePipeWrite(_scheduler, process->pid);
-            SchedulerAddReady(_scheduler, process);
-            return process->pid;
-        }
+    // 2. Pipe writers take turns in the order they arrive, so wake the first one in line.
+    return SchedulerWake(_scheduler, _queue, 0);
+}
 
-        // If write_pid is set, then we should only return the process with a matching pid
-        if (process->pid == _write_pid) {
-            TracePrintf(1, "[SchedulerUpdatePipeWrite] Moving process: %d to ready\n", process->pid);
-            SchedulerRemovePipeWrite(_scheduler, process->pid);
-            SchedulerAddReady(_scheduler, process);
-            return process->pid;
-        }
-        node = node->next;
+int SchedulerUpdateSwap(scheduler_t *_scheduler, pcb_queue_t *_queue) {
+    // 1. Check arguments. Return error if invalid.
+    if (!_scheduler || !_queue) {
+        TracePrintf(1, "[SchedulerUpdateSwap] Invalid list or queue pointer\n");
+        return ERROR;
     }
-    return 0;
+
+    // 2. Processes waiting on swap each wait for something different (a page, a free frame, or
+    //    a free buffer), so wake them all and let each one check whether it can proceed.
+    return SchedulerUpdateCVarAll(_scheduler, _queue);
 }
 
 // \desc    This function should be called by a *parent* process in SyscallExit only, as it is used
@@ -944,7 +919,8 @@ int SchedulerUpdateTerminated(scheduler_t *_scheduler, pcb_t *_parent) {
         if (child->exited) {
             TracePrintf(1, "[SchedulerUpdateTerminated] Removing child %d.\n",
                            child->pid);
-            SchedulerRemoveTerminated(_scheduler, child->pid);
+            SchedulerUnlink(child);
+            SchedulerProcessRemove(_scheduler, child->pid);
             ProcessDestroy(child);
         }
         child = next;
@@ -952,72 +928,42 @@ int SchedulerUpdateTerminated(scheduler_t *_scheduler, pcb_t *_parent) {
     return 0;
 }
 
-int SchedulerUpdateTTYRead(scheduler_t *_scheduler, int _tty_id, int _read_pid) {
+int SchedulerUpdateTTYRead(scheduler_t *_scheduler, pcb_queue_t *_queue, int _read_pid) {
     // 1. Check arguments. Return error if invalid.
-    if (!_scheduler) {
-        TracePrintf(1, "[SchedulerUpdateTTYRead] Invalid list pointer\n");
+    if (!_scheduler || !_queue) {
+        TracePrintf(1, "[SchedulerUpdateTTYRead] Invalid list or queue pointer\n");
         return ERROR;
     }
 
-    // 2. Loop over the TTYRead list to see if any processes are waiting to read from the terminal
-    //    specified by _tty_id. If so, remove the first (and only the first) process waiting to
-    //    read and add it to the ready list.
-    node_t *node = _scheduler->lists[SCHEDULER_TTY_READ_START];
-    while (node) {
-
-        // If read_pid = 0, then there is not currently a process reading from the tty.
-        // So, we should just return the first process with a matching tty_id
-        pcb_t *process = node->process;
-        if (process->tty_id == _tty_id && _read_pid == 0) {
-            TracePrintf(1, "[SchedulerUpdateTTYRead] Moving process: %d to ready\n", process->pid);
-            SchedulerRemoveTTYRead(_scheduler, process->pid);
-            SchedulerAddReady(_scheduler, process);
-            return process->pid;
-        }
+    // 2. If read_pid = 0, then there is not currently a process reading from the tty, so wake
+    //    the first process waiting to read. If read_pid is set, then only wake that process.
+    return SchedulerWake(_scheduler, _queue, _read_pid);
+}
 
-        // If read_pid is set, then we should only return the process with a matching pid
-        if (process->pid == _read_pid) {
-            TracePrintf(1, "[SchedulerUpdateTTYRead] Moving process: %d to ready\n", process->pid);
-            SchedulerRemoveTTYRead(_scheduler, process->pid);
-            SchedulerAddReady(_scheduler, process);
-            return process->pid;
-        }
-        node = node->next;
+int SchedulerUpdateTTYWrite(scheduler_t *_scheduler, pcb_queue_t *_queue, int _write_pid) {
+    // 1. Check arguments. Return error if invalid.
+    if (!_scheduler || !_queue) {
+        helper_abort("[SchedulerUpdateTTYWrite] Invalid list or queue pointer\n");
     }
-    return 0;
+
+    // 2. If write_pid = 0, then there is not currently a process writing to the tty, so wake
+    //    the first process waiting to write. If write_pid is set, then only wake that process.
+    int pid = SchedulerWake(_scheduler, _queue, _write_pid);
+    if (!pid) {
+        TracePrintf(1, "[SchedulerUpdateTTYWrite] No process waiting\n");
+    }
+    return pid;
 }
 
-int SchedulerUpdateTTYWrite(scheduler_t *_scheduler, int _tty_id, int _write_pid) {
+int SchedulerUpdateVfork(scheduler_t *_scheduler, pcb_queue_t *_queue) {
     // 1. Check arguments. Return error if invalid.
-    if (!_scheduler) {
-        helper_abort("[SchedulerUpdateTTYWrite] Invalid list pointer\n");
-    }
-
-    // 2.
-    node_t *node = _scheduler->lists[SCHEDULER_TTY_WRITE_START];
-    while (node) {
-        
-        // If write_pid = 0, then there is not currently a process writing to the tty.
-        // So, we should just return the first process with a matching tty_id
-        pcb_t *process = node->process;
-        if (process->tty_id == _tty_id && _write_pid == 0) {
-            TracePrintf(1, "[SchedulerUpdateTTYWrite] Moving process: %d to ready\n", process->pid);
-            SchedulerRemoveTTYWrite(_scheduler, process->pid);
-            SchedulerAddReady(_scheduler, process);
-            return process->pid;
-        }
-
-        // If write_pid is set, then we should only return the process with a matching pid
-        if (process->pid == _write_pid) {
-            TracePrintf(1, "[SchedulerUpdateTTYWrite] Moving process: %d to ready\n", process->pid);
-            SchedulerRemoveTTYWrite(_scheduler, process->pid);
-            SchedulerAddReady(_scheduler, process);
-            return process->pid;
-        }
-        node = node->next;
+    if (!_scheduler || !_queue) {
+        TracePrintf(1, "[SchedulerUpdateVfork] Invalid list or queue pointer\n");
+        return ERROR;
     }
-    TracePrintf(1, "[SchedulerUpdateTTYWrite] No process waiting for tty_id = %d\n", _tty_id);
-    return 0;
+
+    // 2. Only the parent that lent its region 1 ever waits here, so just wake it.
+    return SchedulerUpdateCVar(_scheduler, _queue);
 }
 
 int SchedulerUpdateWait(scheduler_t *_scheduler, int _pid) {
@@ -1031,8 +977,300 @@ int SchedulerUpdateWait(scheduler_t *_scheduler, int _pid) {
     //    If so, remove them and move them to the ready list.
     pcb_t *parent = SchedulerGetWait(_scheduler, _pid);
     if (parent) {
-        SchedulerRemoveWait(_scheduler, _pid);
+        SchedulerUnlink(parent);
         SchedulerAddReady(_scheduler, parent);
     }
     return 0;
-}
\ No newline at end of file
+}
+
+
+/*!
+ * \desc                  Sets the MLFQ priority level of a process (0 is the highest priority). If the
+ *                        process is currently on a ready list it is moved to the end of the ready
+ *                        list for its new level. The process starts a fresh quantum at that level,
+ *                        and the usual demotion/promotion/aging rules apply from there on.
+ *
+ * \param[in] _scheduler  An initialized scheduler_t struct
+ * \param[in] _process    The PCB of the process whose priority the caller wishes to change
+ * \param[in] _priority   The new priority level, between 0 and SCHEDULER_NUM_PRIORITIES - 1
+ * 
+ * \return                0 on success, ERROR otherwise.
+ */
+int SchedulerSetPriority(scheduler_t *_scheduler, pcb_t *_process, int _priority) {
+    // 1. Check arguments. Return error if invalid.
+    if (!_scheduler || !_process) {
+        TracePrintf(1, "[SchedulerSetPriority] Invalid list or process pointer\n");
+        return ERROR;
+    }
+    if (_priority < 0 || _priority >= SCHEDULER_NUM_PRIORITIES) {
+        TracePrintf(1, "[SchedulerSetPriority] Invalid priority: %d\n", _priority);
+        return ERROR;
+    }
+
+    // 2. Update the priority, moving the process between ready lists if it is currently ready.
+    int ready = SchedulerIsReady(_scheduler, _process);
+    if (ready) {
+        SchedulerUnlink(_process);
+    }
+    _process->priority      = _priority;
+    _process->quantum_ticks = 0;
+    if (ready) {
+        _scheduler->policy->add_ready(_scheduler, _process);
+    }
+    return 0;
+}
+
+
+/*!
+ * \desc                  Sets the number of tickets a process holds under the stride scheduling
+ *                        policy. A process is given cpu time in proportion to its share of the
+ *                        tickets held by all ready processes. If the process is currently ready
+ *                        it is re-inserted so that the ready list stays ordered by pass value.
+ *
+ * \param[in] _scheduler  An initialized scheduler_t struct
+ * \param[in] _process    The PCB of the process whose tickets the caller wishes to change
+ * \param[in] _tickets    The new number of tickets, between 1 and SCHEDULER_MAX_TICKETS
+ * 
+ * \return                0 on success, ERROR otherwise.
+ */
+int SchedulerSetTickets(scheduler_t *_scheduler, pcb_t *_process, int _tickets) {
+    // 1. Check arguments. Return error if invalid.
+    if (!_scheduler || !_process) {
+        TracePrintf(1, "[SchedulerSetTickets] Invalid list or process pointer\n");
+        return ERROR;
+    }
+    if (_tickets < 1 || _tickets > SCHEDULER_MAX_TICKETS) {
+        TracePrintf(1, "[SchedulerSetTickets] Invalid tickets: %d\n", _tickets);
+        return ERROR;
+    }
+
+    // 2. A process' stride is inversely proportional to its tickets. Re-insert it into the ready
+    //    list if it is currently ready.
+    int ready = SchedulerIsReady(_scheduler, _process);
+    if (ready) {
+        SchedulerUnlink(_process);
+    }
+    _process->tickets = _tickets;
+    _process->stride  = SCHEDULER_STRIDE1 / _tickets;
+    if (ready) {
+        _scheduler->policy->add_ready(_scheduler, _process);
+    }
+    return 0;
+}
+
+
+/*!
+ * \desc                  Selects the scheduling policy by name ("rr", "mlfq", or "stride"). This
+ *                        should only be called at boot, before any process has been made ready.
+ *
+ * \param[in] _scheduler  An initialized scheduler_t struct
+ * \param[in] _name       The name of the policy to use
+ * 
+ * \return                0 on success, ERROR otherwise.
+ */
+int SchedulerSetPolicy(scheduler_t *_scheduler, char *_name) {
+    // 1. Check arguments. Return error if invalid.
+    if (!_scheduler || !_name) {
+        TracePrintf(1, "[SchedulerSetPolicy] Invalid list or name pointer\n");
+        return ERROR;
+    }
+
+    // 2. Look the policy up by name.
+    for (int i = 0; i < SCHEDULER_NUM_POLICIES; i++) {
+        if (!strcmp(s_policies[i].name, _name)) {
+            TracePrintf(1, "[SchedulerSetPolicy] Using scheduling policy: %s\n", _name);
+            _scheduler->policy = &s_policies[i];
+            return 0;
+        }
+    }
+    TracePrintf(1, "[SchedulerSetPolicy] Unknown scheduling policy: %s\n", _name);
+    return ERROR;
+}
+
+
+static int SchedulerWake(scheduler_t *_scheduler, pcb_queue_t *_queue, int _pid) {
+    // 1. If _pid is 0, wake whoever is at the front of the queue. Otherwise, only wake the process
+    //    specified by _pid, and only if it is actually waiting on this queue.
+    pcb_t *process = _queue->start;
+    if (_pid) {
+        process = SchedulerProcessGet(_scheduler, _pid);
+    }
+    if (!process || process->queue != _queue) {
+        return 0;
+    }
+
+    // 2. Move the process from the wait queue to the ready list and return its pid.
+    TracePrintf(1, "[SchedulerWake] Moving process: %d to ready\n", process->pid);
+    SchedulerUnlink(process);
+    SchedulerAddReady(_scheduler, process);
+    return process->pid;
+}
+
+static int SchedulerIsReady(scheduler_t *_scheduler, pcb_t *_process) {
+    // 1. Check whether the process is sitting on any one of our ready lists.
+    return _process->queue >= &_scheduler->ready[0] &&
+           _process->queue <  &_scheduler->ready[SCHEDULER_NUM_PRIORITIES];
+}
+
+static void SchedulerInsertAfter(pcb_queue_t *_queue, pcb_t *_prev, pcb_t *_process) {
+    // 1. Link the process into the queue directly after _prev, or at the front if _prev is NULL.
+    //    This is used by the lists that are kept sorted (the delay wheel and the stride list).
+    _process->queue      = _queue;
+    _process->queue_prev = _prev;
+    if (_prev) {
+        _process->queue_next = _prev->queue_next;
+        _prev->queue_next    = _process;
+    } else {
+        _process->queue_next = _queue->start;
+        _queue->start        = _process;
+    }
+    if (_process->queue_next) {
+        _process->queue_next->queue_prev = _process;
+    } else {
+        _queue->end = _process;
+    }
+}
+
+
+/*!
+ * \desc    ROUND ROBIN POLICY - A single FIFO ready list. Every process runs for one clock tick
+ *          before going to the back of the line.
+ */
+static int SchedulerRRAddReady(scheduler_t *_scheduler, pcb_t *_process) {
+    return SchedulerAdd(&_scheduler->ready[0], _process);
+}
+
+static pcb_t *SchedulerRRGetReady(scheduler_t *_scheduler) {
+    pcb_t *process = _scheduler->ready[0].start;
+    if (process) {
+        SchedulerUnlink(process);
+    }
+    return process;
+}
+
+static int SchedulerRRUpdateQuantum(scheduler_t *_scheduler, pcb_t *_process) {
+    return 1;
+}
+
+
+/*!
+ * \desc    MLFQ POLICY - One FIFO ready list per priority level (see scheduler.h). A process that
+ *          uses its whole quantum is demoted, one that blocks for input is promoted, and waiting
+ *          ready processes are periodically aged up a level.
+ */
+static int SchedulerMLFQAddReady(scheduler_t *_scheduler, pcb_t *_process) {
+    // 1. Add the process to the end of the ready list for its current priority level.
+    return SchedulerAdd(&_scheduler->ready[_process->priority], _process);
+}
+
+static pcb_t *SchedulerMLFQGetReady(scheduler_t *_scheduler) {
+    // 1. Pop the process at the front of the highest priority ready list that is not empty.
+    for (int i = 0; i < SCHEDULER_NUM_PRIORITIES; i++) {
+        pcb_t *process = _scheduler->ready[i].start;
+        if (process) {
+            SchedulerUnlink(process);
+            return process;
+        }
+    }
+    return NULL;
+}
+
+static int SchedulerMLFQUpdateQuantum(scheduler_t *_scheduler, pcb_t *_process) {
+    // 1. Charge the process for the tick. If it has used up the full quantum for its priority
+    //    level (which doubles at every level down), demote it a level and preempt it.
+    _process->quantum_ticks++;
+    if (_process->quantum_ticks >= SCHEDULER_QUANTUM(_process->priority)) {
+        if (_process->priority < SCHEDULER_NUM_PRIORITIES - 1) {
+            _process->priority++;
+        }
+        _process->quantum_ticks = 0;
+        return 1;
+    }
+
+    // 2. Otherwise, only preempt the process if something with a higher priority is now ready.
+    for (int i = 0; i < _process->priority; i++) {
+        if (_scheduler->ready[i].start) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+
+static int SchedulerMLFQUpdateAging(scheduler_t *_scheduler) {
+    // 1. Only age processes once every SCHEDULER_AGING_TICKS ticks.
+    if (_scheduler->ticks % SCHEDULER_AGING_TICKS) {
+        return 0;
+    }
+
+    // 2. Move every process waiting in a lower priority ready list up one level so that CPU bound
+    //    processes that were demoted do not starve. We go from the highest level down so that a
+    //    process is only ever moved once per aging pass.
+    for (int i = 1; i < SCHEDULER_NUM_PRIORITIES; i++) {
+        pcb_t *process = _scheduler->ready[i].start;
+        while (process) {
+            pcb_t *next = process->queue_next;
+            SchedulerUnlink(process);
+            process->priority--;
+            process->quantum_ticks = 0;
+            SchedulerAdd(&_scheduler->ready[process->priority], process);
+            process = next;
+        }
+    }
+    return 0;
+}
+
+
+static void SchedulerMLFQPromote(pcb_t *_process) {
+    // 1. Move the process up one priority level (if it is not already at the top) and give it a
+    //    fresh quantum at its new level.
+    if (_process->priority > 0) {
+        _process->priority--;
+    }
+    _process->quantum_ticks = 0;
+}
+
+
+/*!
+ * \desc    STRIDE POLICY - Each process has a stride inversely proportional to its tickets and a
+ *          pass value that advances by its stride for every tick it runs. The ready list is kept
+ *          sorted by pass, and the process with the smallest pass runs next, so over time each
+ *          process gets cpu time in proportion to its tickets.
+ */
+static int SchedulerStrideAddReady(scheduler_t *_scheduler, pcb_t *_process) {
+    // 1. A process that has been blocked for a while should not be able to monopolize the cpu
+    //    to "catch up", so never let its pass fall behind that of the last dispatched process.
+    if (_process->pass < _scheduler->pass) {
+        _process->pass = _scheduler->pass;
+    }
+
+    // 2. Walk backwards from the end of the list to find the process we should be inserted
+    //    after, keeping processes with equal pass values in FIFO order.
+    pcb_queue_t *queue = &_scheduler->ready[0];
+    pcb_t *prev = queue->end;
+    while (prev && prev->pass > _process->pass) {
+        prev = prev->queue_prev;
+    }
+    SchedulerInsertAfter(queue, prev, _process);
+    return 0;
+}
+
+static pcb_t *SchedulerStrideGetReady(scheduler_t *_scheduler) {
+    // 1. The list is sorted, so the process with the smallest pass is at the front.
+    pcb_t *process = _scheduler->ready[0].start;
+    if (process) {
+        SchedulerUnlink(process);
+        _scheduler->pass = process->pass;
+    }
+    return process;
+}
+
+static int SchedulerStrideUpdateQuantum(scheduler_t *_scheduler, pcb_t *_process) {
+    // 1. Advance the process' pass by its stride for the tick it just ran, then preempt it so
+    //    that whichever process now has the smallest pass gets to run. The global pass is kept
+    //    current here as well, since TrapClock does not go through get_ready when the running
+    //    process is the only one that is runnable.
+    _scheduler->pass  = _process->pass;
+    _process->pass   += _process->stride;
+    return 1;
+}
@@ -3,31 +3,31 @@
 #include <hardware.h>
 #include "process.h"
 
-#define SCHEDULER_CVAR_START       0
-#define SCHEDULER_CVAR_END         1
-#define SCHEDULER_DELAY_START      2
-#define SCHEDULER_DELAY_END        3
-#define SCHEDULER_LOCK_START       4
-#define SCHEDULER_LOCK_END         5
-#define SCHEDULER_PIPE_READ_START  6
-#define SCHEDULER_PIPE_READ_END    7
-#define SCHEDULER_PIPE_WRITE_START 8
-#define SCHEDULER_PIPE_WRITE_END   9
-#define SCHEDULER_PROCESSES_START  10
-#define SCHEDULER_PROCESSES_END    11
-#define SCHEDULER_READY_START      12
-#define SCHEDULER_READY_END        13
-#define SCHEDULER_TERMINATED_START 14
-#define SCHEDULER_TERMINATED_END   15
-#define SCHEDULER_TTY_READ_START   16
-#define SCHEDULER_TTY_READ_END     17
-#define SCHEDULER_TTY_WRITE_START  18
-#define SCHEDULER_TTY_WRITE_END    19
-#define SCHEDULER_WAIT_START       20
-#define SCHEDULER_WAIT_END         21
-#define SCHEDULER_RUNNING          22
-#define SCHEDULER_IDLE             23
-#define SCHEDULER_NUM_LISTS        24
+#define SCHEDULER_TERMINATED       0
+#define SCHEDULER_WAIT             1
+#define SCHEDULER_NUM_LISTS        2
+
+// Under the "mlfq" policy the ready list is a multi-level feedback queue. Level 0 is the highest
+// priority. A process that uses up the full quantum for its level (which doubles at every level
+// down) is demoted a level, a process that blocks waiting for tty or pipe input is promoted a
+// level, and every SCHEDULER_AGING_TICKS ticks each waiting ready process is moved up a level.
+#define SCHEDULER_NUM_PRIORITIES   4
+#define SCHEDULER_QUANTUM(level)   (1 << (level))
+#define SCHEDULER_AGING_TICKS      50
+
+// Under the "stride" policy each process has a stride of SCHEDULER_STRIDE1 / tickets and the
+// ready process with the smallest pass value runs next, so cpu time is shared in proportion to
+// tickets. New processes get SCHEDULER_DEFAULT_TICKETS (children inherit their parent's).
+#define SCHEDULER_STRIDE1          (1 << 20)
+#define SCHEDULER_DEFAULT_TICKETS  100
+#define SCHEDULER_MAX_TICKETS      10000
+
+// Number of slots in the timing wheel used for Delay. A process delayed for longer than this
+// many ticks simply sits in its slot for more than one lap of the wheel.
+#define SCHEDULER_WHEEL_SIZE       64
+
+// Number of buckets in the pid-hashed process table used by the pid-based getters/removers.
+#define SCHEDULER_PID_BUCKETS      256
 
 
 typedef struct scheduler scheduler_t;
@@ -48,59 +48,59 @@ scheduler_t *SchedulerCreate();
  */
 int SchedulerDelete(scheduler_t *_scheduler);
 
-int    SchedulerAddCVar(scheduler_t *_scheduler, pcb_t *_process);
+int    SchedulerAddCVar(scheduler_t *_scheduler, pcb_queue_t *_queue, pcb_t *_process);
 int    SchedulerAddDelay(scheduler_t *_scheduler, pcb_t *_process);
 int    SchedulerAddIdle(scheduler_t *_scheduler, pcb_t *_process);
-int    SchedulerAddLock(scheduler_t *_scheduler, pcb_t *_process);
-int    SchedulerAddPipeRead(scheduler_t *_scheduler, pcb_t *_process);
-int    SchedulerAddPipeWrite(scheduler_t *_scheduler, pcb_t *_process);
+int    SchedulerAddLock(scheduler_t *_scheduler, pcb_queue_t *_queue, pcb_t *_process);
+int    SchedulerAddPipeRead(scheduler_t *_scheduler, pcb_queue_t *_queue, pcb_t *_process);
+int    SchedulerAddPipeWrite(scheduler_t *_scheduler, pcb_queue_t *_queue, pcb_t *_process);
 int    SchedulerAddProcess(scheduler_t *_scheduler, pcb_t *_process);
 int    SchedulerAddReady(scheduler_t *_scheduler, pcb_t *_process);
 int    SchedulerAddRunning(scheduler_t *_scheduler, pcb_t *_process);
+int    SchedulerAddSwap(scheduler_t *_scheduler, pcb_queue_t *_queue, pcb_t *_process);
 int    SchedulerAddTerminated(scheduler_t *_scheduler, pcb_t *_process);
-int    SchedulerAddTTYRead(scheduler_t *_scheduler, pcb_t *_process);
-int    SchedulerAddTTYWrite(scheduler_t *_scheduler, pcb_t *_process);
+int    SchedulerAddTTYRead(scheduler_t *_scheduler, pcb_queue_t *_queue, pcb_t *_process);
+int    SchedulerAddTTYWrite(scheduler_t *_scheduler, pcb_queue_t *_queue, pcb_t *_process);
+int    SchedulerAddVfork(scheduler_t *_scheduler, pcb_queue_t *_queue, pcb_t *_process);
 int    SchedulerAddWait(scheduler_t *_scheduler, pcb_t *_process);
 
 pcb_t *SchedulerGetIdle(scheduler_t *_scheduler);
 pcb_t *SchedulerGetProcess(scheduler_t *_scheduler, int _pid);
 pcb_t *SchedulerGetReady(scheduler_t *_scheduler);
 pcb_t *SchedulerGetRunning(scheduler_t *_scheduler);
+unsigned long SchedulerGetTicks(scheduler_t *_scheduler);
 pcb_t *SchedulerGetTerminated(scheduler_t *_scheduler, int _pid);
-pcb_t *SchedulerGetTTYWrite(scheduler_t *_scheduler);
 pcb_t *SchedulerGetWait(scheduler_t *_scheduler, int _pid);
+int    SchedulerHasReady(scheduler_t *_scheduler);
 
-int    SchedulerPrintCVar(scheduler_t *_scheduler);
 int    SchedulerPrintDelay(scheduler_t *_scheduler);
-int    SchedulerPrintLock(scheduler_t *_scheduler);
-int    SchedulerPrintPipeRead(scheduler_t *_scheduler);
-int    SchedulerPrintPipeWrite(scheduler_t *_scheduler);
 int    SchedulerPrintProcess(scheduler_t *_scheduler);
 int    SchedulerPrintReady(scheduler_t *_scheduler);
 int    SchedulerPrintTerminated(scheduler_t *_scheduler);
-int    SchedulerPrintTTYRead(scheduler_t *_scheduler);
-int    SchedulerPrintTTYWrite(scheduler_t *_scheduler);
 int    SchedulerPrintWait(scheduler_t *_scheduler);
 
-int    SchedulerRemoveCVar(scheduler_t *_scheduler, int _pid);
 int    SchedulerRemoveDelay(scheduler_t *_scheduler, int _pid);
-int    SchedulerRemoveLock(scheduler_t *_scheduler, int _pid);
-int    SchedulerRemovePipeRead(scheduler_t *_scheduler, int _pid);
-int    SchedulerRemovePipeWrite(scheduler_t *_scheduler, int _pid);
 int    SchedulerRemoveProcess(scheduler_t *_scheduler, int _pid);
 int    SchedulerRemoveReady(scheduler_t *_scheduler, int _pid);
 int    SchedulerRemoveTerminated(scheduler_t *_scheduler, int _pid);
-int    SchedulerRemoveTTYRead(scheduler_t *_scheduler, int _pid);
-int    SchedulerRemoveTTYWrite(scheduler_t *_scheduler, int _pid);
 int    SchedulerRemoveWait(scheduler_t *_scheduler, int _pid);
 
-int    SchedulerUpdateCVar(scheduler_t *_scheduler, int _cvar_id);
+int    SchedulerUpdateCVar(scheduler_t *_scheduler, pcb_queue_t *_queue);
+int    SchedulerUpdateCVarAll(scheduler_t *_scheduler, pcb_queue_t *_queue);
+int    SchedulerUpdateAging(scheduler_t *_scheduler);
 int    SchedulerUpdateDelay(scheduler_t *_scheduler);
-int    SchedulerUpdateLock(scheduler_t *_scheduler, int _lock_id);
-int    SchedulerUpdatePipeRead(scheduler_t *_scheduler, int _pipe_id, int _read_pid);
-int    SchedulerUpdatePipeWrite(scheduler_t *_scheduler, int _pipe_id, int _write_pid);
+int    SchedulerUpdateLock(scheduler_t *_scheduler, pcb_queue_t *_queue);
+int    SchedulerUpdatePipeRead(scheduler_t *_scheduler, pcb_queue_t *_queue);
+int    SchedulerUpdatePipeWrite(scheduler_t *_scheduler, pcb_queue_t *_queue);
+int    SchedulerUpdateQuantum(scheduler_t *_scheduler, pcb_t *_process);
+int    SchedulerUpdateSwap(scheduler_t *_scheduler, pcb_queue_t *_queue);
 int    SchedulerUpdateTerminated(scheduler_t *_scheduler, pcb_t *_parent);
-int    SchedulerUpdateTTYRead(scheduler_t *_scheduler, int _tty_id, int _read_pid);
-int    SchedulerUpdateTTYWrite(scheduler_t *_scheduler, int _tty_id, int _write_pid);
+int    SchedulerUpdateTTYRead(scheduler_t *_scheduler, pcb_queue_t *_queue, int _read_pid);
+int    SchedulerUpdateTTYWrite(scheduler_t *_scheduler, pcb_queue_t *_queue, int _write_pid);
+int    SchedulerUpdateVfork(scheduler_t *_scheduler, pcb_queue_t *_queue);
 int    SchedulerUpdateWait(scheduler_t *_scheduler, int _pid);
+
+int    SchedulerSetPolicy(scheduler_t *_scheduler, char *_name);
+int    SchedulerSetPriority(scheduler_t *_scheduler, pcb_t *_process, int _priority);
+int    SchedulerSetTickets(scheduler_t *_scheduler, pcb_t *_process, int _tickets);
 #endif // __SCHEDULER_H
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include "kernel.h"
 #include "bitvec.h"
 #include "pte.h"
+#include "slab.h"
 
 typedef struct sem {
   int val;
@@ -14,6 +15,10 @@ typedef struct sem {
 
 dllist *e_sem_list = NULL;
 
+static slab_cache_t g_sem_cache = SLAB_CACHE_INIT("sem_t", sizeof(sem_t), NULL);
+
+static void SemDelete(int sem_id);
+
 int SemInit(int *sem_idp, int val) {
     // null pointer check
     if (sem_idp == NULL) {
@@ -25,10 +30,10 @@ int SemInit(int *sem_idp, int val) {
     pcb_t *running_old = SchedulerGetRunning(e_scheduler);
 
     // check if pointed-to address is in region 1 and writable
-    int ret = PTECheckAddress(running_old->pt,
-                              sem_idp,
-                              sizeof(int),
-                              PROT_WRITE);
+    int ret = ProcessCheckAddress(running_old,
+                                  sem_idp,
+                                  sizeof(int),
+                                  PROT_WRITE);
     if (ret < 0) {
         TracePrintf(1, "[SyscallSemInit] semaphore pointer is not within valid address space\n");
         return ERROR;
@@ -41,8 +46,8 @@ int SemInit(int *sem_idp, int val) {
     }
     *sem_idp = new_id;
 
-    // Malloc a new sem_t node and set up its members
-    sem_t *new_sem = malloc(sizeof(sem_t));
+    // Allocate a new sem_t node and set up its members
+    sem_t *new_sem = SlabAlloc(&g_sem_cache);
     if (new_sem == NULL) {
         return ERROR;
     }
@@ -50,14 +55,14 @@ int SemInit(int *sem_idp, int val) {
 
     ret = LockInit(e_lock_list, &new_sem->lock_id, 0);
     if (ret == ERROR) {
-        free(new_sem);
+        SlabFree(&g_sem_cache, new_sem);
         return ERROR;
     }
 
     ret = CVarInit(e_cvar_list, &new_sem->cvar_id, 0);
     if (ret == ERROR) {
         LockReclaim(e_lock_list, new_sem->lock_id);
-        free(new_sem);
+        SlabFree(&g_sem_cache, new_sem);
         return ERROR;
     }
 
@@ -65,7 +70,7 @@ int SemInit(int *sem_idp, int val) {
     if (ret == ERROR) {
         LockReclaim(e_lock_list, new_sem->lock_id);
         CVarReclaim(e_cvar_list, new_sem->cvar_id);
-        free(new_sem);
+        SlabFree(&g_sem_cache, new_sem);
         return ERROR;
     }
 
@@ -73,8 +78,7 @@ int SemInit(int *sem_idp, int val) {
     if (ret == ERROR) {
         LockReclaim(e_lock_list, new_sem->lock_id);
         CVarReclaim(e_cvar_list, new_sem->cvar_id);
-        list_delete_key(e_sem_list, new_id);
-        free(new_sem);
+        SemDelete(new_id);
         return ERROR;
     }
     return SUCCESS;
@@ -155,11 +159,22 @@ int SemReclaim(int sem_id) {
     SemIDRetire(sem_id);
 
     // delete the semaphore node from the global semaphore list
-    list_delete_key(e_sem_list, sem_id);
+    SemDelete(sem_id);
 
     // remove the semaphore id from the process's resource list
     pcb_t *running = SchedulerGetRunning(e_scheduler);
     list_delete_key(running->res_list, sem_id);
 
     return SUCCESS;
-}
\ No newline at end of file
+}
+
+static void SemDelete(int sem_id) {
+    // the list would free() the node's data, so hand the sem_t back to its cache first
+    dlnode_t *node = list_find(e_sem_list, sem_id);
+    if (node == NULL) {
+        return;
+    }
+    SlabFree(&g_sem_cache, node->data);
+    node->data = NULL;
+    list_delete_key(e_sem_list, sem_id);
+}
@@ -0,0 +1,123 @@
+#include <hardware.h>
+#include <ykernel.h>
+#include "slab.h"
+
+// Objects (and slab headers) are aligned to pointer size, and each object is followed by the
+// free list link for its slot.
+#define SLAB_ALIGN(size)      (((size) + sizeof(void *) - 1) & ~(sizeof(void *) - 1))
+#define SLAB_SLOT_SIZE(cache) (SLAB_ALIGN((cache)->obj_size) + sizeof(void *))
+#define SLAB_LINK(cache, obj) (*(void **) ((char *) (obj) + SLAB_ALIGN((cache)->obj_size)))
+
+
+/*
+ * Local Global Variable Definitions
+ */
+static slab_cache_t *g_caches = NULL;   // Every cache that has allocated a slab (for SlabPrint)
+
+
+/*
+ * Local Function Definitions
+ */
+static int SlabRefill(slab_cache_t *_cache);
+static int SlabPrintCache(slab_cache_t *_cache);
+
+
+void *SlabAlloc(slab_cache_t *_cache) {
+    // 1. Check arguments. Return error if invalid.
+    if (!_cache || _cache->obj_size < 1) {
+        TracePrintf(1, "[SlabAlloc] Invalid cache pointer\n");
+        return NULL;
+    }
+
+    // 2. If the cache has no free objects, carve some out of a new slab.
+    if (!_cache->free_list && SlabRefill(_cache) == ERROR) {
+        TracePrintf(1, "[SlabAlloc] Unable to refill cache: %s\n", _cache->name);
+        return NULL;
+    }
+
+    // 3. Pop an object off of the cache's free list.
+    void *obj          = _cache->free_list;
+    _cache->free_list  = SLAB_LINK(_cache, obj);
+    _cache->num_in_use++;
+    _cache->num_allocs++;
+    return obj;
+}
+
+
+void SlabFree(slab_cache_t *_cache, void *_obj) {
+    // 1. Check arguments. Like free, freeing NULL does nothing.
+    if (!_cache) {
+        TracePrintf(1, "[SlabFree] Invalid cache pointer\n");
+        Halt();
+    }
+    if (!_obj) {
+        return;
+    }
+
+    // 2. Push the object back onto the cache's free list. We keep the slab around, so the next
+    //    allocation of this type can reuse the object without going to the heap.
+    SLAB_LINK(_cache, _obj) = _cache->free_list;
+    _cache->free_list       = _obj;
+    _cache->num_in_use--;
+    _cache->num_frees++;
+}
+
+
+void SlabPrint(slab_cache_t *_cache) {
+    // 1. Print the single cache if one was given. Otherwise, print every cache in use.
+    if (_cache) {
+        SlabPrintCache(_cache);
+        return;
+    }
+    for (slab_cache_t *cache = g_caches; cache; cache = cache->next) {
+        SlabPrintCache(cache);
+    }
+}
+
+
+static int SlabRefill(slab_cache_t *_cache) {
+    // 1. Figure out how big the slab should be: one page, unless that does not hold at least
+    //    SLAB_MIN_OBJECTS objects (plus the slab header), in which case round up to more pages.
+    int header_size = SLAB_ALIGN(sizeof(void *));
+    int slot_size   = SLAB_SLOT_SIZE(_cache);
+    int slab_size   = UP_TO_PAGE(header_size + slot_size * SLAB_MIN_OBJECTS);
+    int num_objects = (slab_size - header_size) / slot_size;
+
+    // 2. Allocate the slab and link it into the cache's list of slabs through its header.
+    char *slab = (char *) malloc(slab_size);
+    if (!slab) {
+        TracePrintf(1, "[SlabRefill] Error mallocing slab for cache: %s\n", _cache->name);
+        return ERROR;
+    }
+    *(void **) slab = _cache->slabs;
+    _cache->slabs   = slab;
+
+    // 3. Carve the slab up into objects, constructing each one, and push them onto the free list.
+    for (int i = 0; i < num_objects; i++) {
+        void *obj = slab + header_size + i * slot_size;
+        if (_cache->ctor) {
+            _cache->ctor(obj);
+        }
+        SLAB_LINK(_cache, obj) = _cache->free_list;
+        _cache->free_list      = obj;
+    }
+
+    // 4. Update our statistics. The first time a cache gets a slab, add it to our list of caches.
+    if (!_cache->num_slabs) {
+        _cache->next = g_caches;
+        g_caches     = _cache;
+    }
+    _cache->num_slabs++;
+    _cache->num_objects += num_objects;
+    TracePrintf(1, "[SlabRefill] Cache: %s grew to %d slabs (%d objects)\n",
+                   _cache->name, _cache->num_slabs, _cache->num_objects);
+    return 0;
+}
+
+
+static int SlabPrintCache(slab_cache_t *_cache) {
+    TracePrintf(1, "[SlabPrint] %s: size: %d slabs: %d objects: %d in use: %d allocs: %d frees: %d\n",
+                   _cache->name, _cache->obj_size, _cache->num_slabs, _cache->num_objects,
+                   _cache->num_in_use, _cache->num_allocs, _cache->num_frees);
+    return 0;
+}
@@ -0,0 +1,65 @@
+#ifndef __SLAB_H
+#define __SLAB_H
+
+// Minimum number of objects carved out of each slab. Slabs are a page unless that would hold
+// fewer objects than this, in which case they are rounded up to enough pages.
+#define SLAB_MIN_OBJECTS  4
+
+
+/*
+ * A slab cache hands out fixed size objects of a single kernel type. Objects are carved out of
+ * page-granular slabs, and freed objects go back on the cache's free list rather than to the
+ * kernel heap, so after warming up the cache never touches the heap at all. The free list is
+ * linked through a word stored *after* each object, so a freed object keeps its contents and
+ * the optional constructor only has to run once, when the object is first carved out.
+ *
+ * Caches are declared statically by the module that owns the type, e.g.
+ *
+ *     static slab_cache_t g_pipe_cache = SLAB_CACHE_INIT("pipe_t", sizeof(pipe_t), NULL);
+ */
+typedef struct slab_cache {
+    char  *name;
+    int    obj_size;            // Size of the objects handed out by this cache
+    void (*ctor)(void *);       // Run on each object when it is carved out of a new slab
+    void  *free_list;           // Free objects, linked through the word after each object
+    void  *slabs;               // Slabs allocated for this cache, linked through their header
+    int    num_slabs;           // Statistics (see SlabPrint)
+    int    num_objects;
+    int    num_in_use;
+    int    num_allocs;
+    int    num_frees;
+    struct slab_cache *next;    // Next cache in the list of every cache in use
+} slab_cache_t;
+
+#define SLAB_CACHE_INIT(_name, _size, _ctor) \
+    { (_name), (_size), (_ctor), NULL, NULL, 0, 0, 0, 0, 0, NULL }
+
+
+/*!
+ * \desc              Allocates an object from the cache, refilling the cache with a new slab if
+ *                    it has no free objects.
+ *
+ * \param[in] _cache  The cache for the type of object the caller wants
+ *
+ * \return            The object on success, NULL otherwise.
+ */
+void *SlabAlloc(slab_cache_t *_cache);
+
+
+/*!
+ * \desc              Returns an object to the cache it was allocated from.
+ *
+ * \param[in] _cache  The cache the object was allocated from
+ * \param[in] _obj    The object to free (NULL is ignored)
+ */
+void SlabFree(slab_cache_t *_cache, void *_obj);
+
+
+/*!
+ * \desc              Prints the occupancy and allocation statistics for one cache, or for every
+ *                    cache in use if _cache is NULL.
+ *
+ * \param[in] _cache  The cache to print, or NULL for all of them
+ */
+void SlabPrint(slab_cache_t *_cache);
+#endif // __SLAB_H
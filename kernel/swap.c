@@ -0,0 +1,728 @@
+#include <hardware.h>
+#include <ykernel.h>
+
+#include "frame.h"
+#include "kernel.h"
+#include "process.h"
+#include "pte.h"
+#include "scheduler.h"
+#include "swap.h"
+
+
+/*
+ * Internal struct definitions
+ */
+typedef struct swap_io {
+    int    busy;            // Buffer is in use (queued, on the disk, or holding a page for SwapIn)
+    int    done;            // The transfer has finished
+    int    op;              // DISK_READ or DISK_WRITE
+    int    slot;            // Swap slot being read or written
+    int    sector;          // Next sector within the slot to transfer
+    char  *buf;             // PAGESIZE bounce buffer in the kernel heap
+    struct swap_io *next;   // Next transfer queued for the disk
+} swap_io_t;
+
+typedef struct swap_zram {
+    short grain;            // First arena grain holding the compressed page
+    short len;              // Compressed length in bytes (0 for an all-zero page)
+} swap_zram_t;
+
+typedef struct swap_owner {
+    pcb_t *process;         // Process (and page) that the frame is mapped to, if any
+    short  page;
+    char   referenced;      // Clock reference bit, set whenever the frame is (re)mapped
+} swap_owner_t;
+
+
+/*
+ * Local Global Variable Definitions
+ */
+static int           g_swap_mode   = SWAP_OFF;
+static swap_io_t     g_ios[SWAP_NUM_BUFFERS];
+static swap_io_t    *g_disk_start  = NULL;      // FIFO of transfers for the disk; the first one
+static swap_io_t    *g_disk_end    = NULL;      // is the one the disk is currently working on
+static unsigned char g_slot_refs[SWAP_MAX_SLOTS];
+static int           g_num_slots   = 0;
+static swap_owner_t *g_owners      = NULL;      // Indexed by frame number
+static int           g_clock_hand  = 0;
+static pcb_queue_t   g_waiters     = {NULL, NULL};
+
+static swap_zram_t   g_zram[SWAP_ZRAM_SLOTS];
+static unsigned int  g_arena_map[SWAP_ZRAM_GRAINS / 32];   // Bit set for each grain in use
+static char         *g_arena       = NULL;
+static char         *g_page_buf    = NULL;      // Uncompressed scratch page
+static char         *g_comp_buf    = NULL;      // Compressed scratch page
+static unsigned short g_lz_table[1 << SWAP_LZ_HASH_BITS];
+
+static int           g_num_pageouts    = 0;
+static int           g_num_pageins     = 0;
+static int           g_num_zram_pages  = 0;     // Pages currently in the arena (but not zero pages)
+static int           g_num_zram_zeros  = 0;     // All-zero pages currently swapped out
+static int           g_num_zram_bytes  = 0;     // Bytes of the arena those pages take up
+static unsigned long g_fault_ticks     = 0;     // Total and worst clock ticks spent in SwapIn
+static unsigned long g_fault_ticks_max = 0;
+
+
+/*
+ * Local Function Definitions
+ */
+static int        SwapArenaAlloc(int _num_grains);
+static void       SwapArenaFree(int _grain, int _num_grains);
+static int        SwapClock(void);
+static int        SwapCompress(unsigned char *_src, unsigned char *_dst, int _max_len);
+static int        SwapCopy(int _pfn, char *_buf, int _to_frame);
+static int        SwapDecompress(unsigned char *_src, int _len, unsigned char *_dst);
+static void       SwapDiskStart(void);
+static swap_io_t *SwapFindWrite(int _slot);
+static swap_io_t *SwapGetBuffer(void);
+static int        SwapGetSlot(void);
+static void       SwapQueue(swap_io_t *_io, int _op, int _slot);
+static void       SwapSlotPut(int _slot);
+static void       SwapWait(pcb_t *_process);
+static int        SwapZramStore(int _slot);
+
+
+int SwapInit(char *_mode) {
+    // 1. Check arguments. Return error if invalid.
+    if (!_mode) {
+        TracePrintf(1, "[SwapInit] Invalid mode pointer\n");
+        return ERROR;
+    }
+    int mode;
+    if (!strcmp(_mode, "off")) {
+        mode = SWAP_OFF;
+    } else if (!strcmp(_mode, "disk")) {
+        mode = SWAP_DISK;
+    } else if (!strcmp(_mode, "zram")) {
+        mode = SWAP_ZRAM;
+    } else {
+        TracePrintf(1, "[SwapInit] Unknown swap mode: %s\n", _mode);
+        return ERROR;
+    }
+
+    // 2. Allocate the reverse map from frames to the pages they are mapped to, which lets the
+    //    clock walk physical memory. Same-page merging walks it too, so we keep it up to date
+    //    even when swapping is off.
+    g_owners = (swap_owner_t *) calloc(e_num_frames, sizeof(swap_owner_t));
+    if (!g_owners) {
+        TracePrintf(1, "[SwapInit] Error mallocing space for frame owners\n");
+        return ERROR;
+    }
+    if (mode == SWAP_OFF) {
+        g_swap_mode = SWAP_OFF;
+        return 0;
+    }
+
+    // 3. Under zram, allocate the arena up front (growing the kernel heap later could need the
+    //    very frames we are trying to free) along with the scratch pages for compressing.
+    if (mode == SWAP_ZRAM) {
+        g_arena    = (char *) malloc(SWAP_ZRAM_ARENA_PAGES * PAGESIZE);
+        g_page_buf = (char *) malloc(PAGESIZE);
+        g_comp_buf = (char *) malloc(SWAP_ZRAM_MAX_LEN);
+        if (!g_arena || !g_page_buf || !g_comp_buf) {
+            TracePrintf(1, "[SwapInit] Error mallocing space for the zram arena\n");
+            return ERROR;
+        }
+        g_swap_mode = SWAP_ZRAM;
+        g_num_slots = SWAP_ZRAM_SLOTS;
+        TracePrintf(1, "[SwapInit] Swapping to a %d page compressed arena\n",
+                       SWAP_ZRAM_ARENA_PAGES);
+        return 0;
+    }
+
+    // 4. Otherwise, allocate the bounce buffers for page transfers to and from the disk.
+    for (int i = 0; i < SWAP_NUM_BUFFERS; i++) {
+        g_ios[i].buf = (char *) malloc(PAGESIZE);
+        if (!g_ios[i].buf) {
+            TracePrintf(1, "[SwapInit] Error mallocing space for bounce buffer\n");
+            return ERROR;
+        }
+    }
+    g_swap_mode = SWAP_DISK;
+    g_num_slots = SWAP_NUM_SLOTS;
+    TracePrintf(1, "[SwapInit] Swapping to disk: %d slots of %d sectors\n",
+                   SWAP_NUM_SLOTS, SWAP_SECTORS);
+    return 0;
+}
+
+
+int SwapDiskDone() {
+    // 1. Make sure that we actually asked the disk to do something.
+    swap_io_t *io = g_disk_start;
+    if (!io) {
+        TracePrintf(1, "[SwapDiskDone] Disk interrupt with no transfer in flight\n");
+        return ERROR;
+    }
+
+    // 2. A page is SWAP_SECTORS sectors, so keep going until the whole page is transferred.
+    io->sector++;
+    if (io->sector < SWAP_SECTORS) {
+        SwapDiskStart();
+        return 0;
+    }
+
+    // 3. The page is done. A finished write frees its buffer (its slot holds the page now), while
+    //    a finished read keeps its buffer until SwapIn copies the page out of it. Start the next
+    //    transfer, then wake everyone waiting on swap so they can check whether they can go on.
+    g_disk_start = io->next;
+    if (!g_disk_start) {
+        g_disk_end = NULL;
+    }
+    io->next = NULL;
+    io->done = 1;
+    if (io->op == DISK_WRITE) {
+        io->busy = 0;
+    }
+    if (g_disk_start) {
+        SwapDiskStart();
+    }
+    SchedulerUpdateSwap(e_scheduler, &g_waiters);
+    return 0;
+}
+
+
+int SwapEvict() {
+    // 1. We need swapping to be on, a slot for the victim, and somewhere to copy it to: a bounce
+    //    buffer for the disk, or the scratch page for zram.
+    if (g_swap_mode == SWAP_OFF) {
+        return ERROR;
+    }
+    swap_io_t *io   = NULL;
+    char      *buf  = g_page_buf;
+    int        slot = SwapGetSlot();
+    if (g_swap_mode == SWAP_DISK) {
+        io  = SwapGetBuffer();
+        buf = io ? io->buf : NULL;
+    }
+    if (!buf || slot == ERROR) {
+        TracePrintf(1, "[SwapEvict] No free %s\n", buf ? "swap slots" : "bounce buffers");
+        return ERROR;
+    }
+
+    // 2. Pick a victim with the clock and copy its contents out. Under zram, the victim also has
+    //    to compress well enough to be worth keeping (and fit in the arena). If it does not, give
+    //    it a second chance and try the next few victims.
+    int pfn = ERROR;
+    for (int i = 0; i < SWAP_ZRAM_TRIES && pfn == ERROR; i++) {
+        pfn = SwapClock();
+        if (pfn == ERROR) {
+            TracePrintf(1, "[SwapEvict] No page can be evicted\n");
+            return ERROR;
+        }
+        if (SwapCopy(pfn, buf, 0) == ERROR) {
+            return ERROR;
+        }
+        if (g_swap_mode == SWAP_ZRAM && SwapZramStore(slot) == ERROR) {
+            g_owners[pfn].referenced = 1;
+            pfn = ERROR;
+        }
+    }
+    if (pfn == ERROR) {
+        TracePrintf(1, "[SwapEvict] No page compresses into the arena\n");
+        return ERROR;
+    }
+    pcb_t *victim = g_owners[pfn].process;
+    int    page   = g_owners[pfn].page;
+    int    prot   = ProcessPTEGet(victim, page)->prot;
+    int    cow    = ProcessPTEGetCOW(victim, page);
+
+    // 3. Mark the page non-resident, remembering its protections, copy-on-write flag and slot,
+    //    and free the frame. Clearing the page may free its leaf table, but then marking it
+    //    swapped just takes the same leaf back off of the slab's free list, so this never calls
+    //    malloc (we may be in the middle of growing the kernel heap) and can not fail.
+    ProcessPTEClear(victim, page);
+    if (PTEDirSetSwapped(&victim->pd, page, prot, slot) == ERROR) {
+        TracePrintf(1, "[SwapEvict] Lost the leaf table for pid: %d page: %d\n",
+                       victim->pid, page);
+        Halt();
+    }
+    PTEDirSetCOW(&victim->pd, page, cow);
+    FrameClear(pfn);
+    g_slot_refs[slot] = 1;
+
+    // 4. For the disk, queue the write. The frame is free already, since the page lives in the
+    //    buffer now.
+    if (io) {
+        SwapQueue(io, DISK_WRITE, slot);
+    }
+    g_num_pageouts++;
+    TracePrintf(1, "[SwapEvict] Evicted pid: %d page: %d frame: %d to slot: %d\n",
+                   victim->pid, page, pfn, slot);
+    SwapPrintStats();
+    return 0;
+}
+
+
+void SwapDrop(pcb_t *_process, int _page_num) {
+    int slot = PTEDirGetSwapped(&_process->pd, _page_num, NULL);
+    if (slot == ERROR) {
+        return;
+    }
+    PTEDirClearSwapped(&_process->pd, _page_num);
+    SwapSlotPut(slot);
+}
+
+
+int SwapFork(pcb_t *_parent, pcb_t *_child) {
+    // 1. Each swapped out page of the parent's is also swapped out for the child, in the same
+    //    slot. Whoever swaps it in first gets their own copy, so there is nothing to copy-on-write.
+    int prot;
+    for (int i = PTEDirNextSwapped(&_parent->pd, 0); i != ERROR;
+             i = PTEDirNextSwapped(&_parent->pd, i + 1)) {
+        int slot = PTEDirGetSwapped(&_parent->pd, i, &prot);
+        if (PTEDirSetSwapped(&_child->pd, i, prot, slot) == ERROR) {
+            return ERROR;
+        }
+        g_slot_refs[slot]++;
+        PTEDirSetCOW(&_child->pd, i, PTEDirGetCOW(&_parent->pd, i));
+    }
+    return 0;
+}
+
+
+int SwapIn(pcb_t *_process, int _page_num) {
+    // 1. Check arguments. Return error if the page is not swapped out.
+    int prot;
+    int slot = PTEDirGetSwapped(&_process->pd, _page_num, &prot);
+    if (slot == ERROR) {
+        TracePrintf(1, "[SwapIn] Page: %d is not swapped out\n", _page_num);
+        return ERROR;
+    }
+
+    // 2. Find a frame for the page (an already zeroed one for a zero page, which then needs no
+    //    copying at all). If there are none (and no pages can be evicted right now), wait for a
+    //    page transfer to finish and try again.
+    unsigned long start = SchedulerGetTicks(e_scheduler);
+    int zero = g_swap_mode == SWAP_ZRAM && !g_zram[slot].len;
+    int pfn  = zero ? FrameAllocZero() : FrameFindAndSet();
+    while (pfn == ERROR) {
+        if (SwapWaitForFrame(_process) == ERROR) {
+            TracePrintf(1, "[SwapIn] Failed to find a free frame\n");
+            return ERROR;
+        }
+        pfn = zero ? FrameAllocZero() : FrameFindAndSet();
+    }
+
+    // 3. Under zram, decompress the page out of the arena. For the disk, if the page is still
+    //    being written out, its contents are still in the write's buffer. Otherwise, read it
+    //    into a buffer (waiting for a free one if need be) and sleep until the disk has read
+    //    the whole page.
+    swap_io_t *io = NULL;
+    if (g_swap_mode == SWAP_ZRAM) {
+        if (!zero &&
+            (SwapDecompress((unsigned char *) g_arena + g_zram[slot].grain * SWAP_ZRAM_GRAIN,
+                            g_zram[slot].len, (unsigned char *) g_page_buf) == ERROR ||
+             SwapCopy(pfn, g_page_buf, 1) == ERROR)) {
+            TracePrintf(1, "[SwapIn] Failed to decompress slot: %d\n", slot);
+            FrameClear(pfn);
+            return ERROR;
+        }
+    } else if ((io = SwapFindWrite(slot))) {
+        SwapCopy(pfn, io->buf, 1);
+    } else {
+        while (!(io = SwapGetBuffer())) {
+            SwapWait(_process);
+        }
+        SwapQueue(io, DISK_READ, slot);
+        while (!io->done) {
+            SwapWait(_process);
+        }
+        SwapCopy(pfn, io->buf, 1);
+        io->busy = 0;
+        SchedulerUpdateSwap(e_scheduler, &g_waiters);
+    }
+
+    // 4. Map the page back in with its old protections and copy-on-write flag, and drop our
+    //    reference to the slot. As in SwapEvict, mapping the page right after clearing it reuses
+    //    the same leaf table, so it can not fail.
+    int cow = PTEDirGetCOW(&_process->pd, _page_num);
+    PTEDirClearSwapped(&_process->pd, _page_num);
+    if (ProcessPTESet(_process, _page_num, prot, pfn) == ERROR) {
+        TracePrintf(1, "[SwapIn] Lost the leaf table for page: %d\n", _page_num);
+        Halt();
+    }
+    ProcessPTESetCOW(_process, _page_num, cow);
+    SwapSlotPut(slot);
+    WriteRegister(REG_TLB_FLUSH, (unsigned int) (VMEM_1_BASE + (_page_num << PAGESHIFT)));
+
+    // 5. Charge the time we took (in clock ticks, the only clock we have) to the fault-in stats.
+    unsigned long ticks = SchedulerGetTicks(e_scheduler) - start;
+    g_fault_ticks += ticks;
+    if (ticks > g_fault_ticks_max) {
+        g_fault_ticks_max = ticks;
+    }
+    g_num_pageins++;
+    TracePrintf(1, "[SwapIn] Swapped in pid: %d page: %d from slot: %d\n",
+                   _process->pid, _page_num, slot);
+    SwapPrintStats();
+    return 0;
+}
+
+
+pcb_t *SwapGetOwner(int _pfn, int *_page_num) {
+    // 1. Only trust the reverse map if the page it names still maps the frame.
+    if (!g_owners || _pfn < 0 || _pfn >= e_num_frames || !g_owners[_pfn].process) {
+        return NULL;
+    }
+    pcb_t *process = g_owners[_pfn].process;
+    pte_t *pte     = ProcessPTEGet(process, g_owners[_pfn].page);
+    if (!pte || pte->pfn != _pfn) {
+        return NULL;
+    }
+    *_page_num = g_owners[_pfn].page;
+    return process;
+}
+
+
+int SwapIsSwapped(pcb_t *_process, int _page_num) {
+    return PTEDirGetSwapped(&_process->pd, _page_num, NULL) != ERROR;
+}
+
+
+void SwapPrintStats() {
+    // 1. The compression ratio (x100) is the size of the pages held in the arena, zero pages
+    //    included, over the bytes they take up in it.
+    int ratio = (g_num_zram_pages + g_num_zram_zeros) * PAGESIZE * 100 /
+                (g_num_zram_bytes ? g_num_zram_bytes : 1);
+    int avg   = g_num_pageins ? (int) (g_fault_ticks * 100 / g_num_pageins) : 0;
+    TracePrintf(1, "[SwapPrintStats] out: %d in: %d fault-in ticks avg: %d.%02d max: %lu\n",
+                   g_num_pageouts, g_num_pageins, avg / 100, avg % 100, g_fault_ticks_max);
+    if (g_swap_mode == SWAP_ZRAM) {
+        TracePrintf(1, "[SwapPrintStats] zram pages: %d zero pages: %d bytes: %d ratio: %d.%02dx\n",
+                       g_num_zram_pages, g_num_zram_zeros, g_num_zram_bytes,
+                       ratio / 100, ratio % 100);
+    }
+}
+
+
+void SwapRelease(pcb_t *_process) {
+    // 1. Drop the process' reference to each of its swap slots and forget the pages.
+    for (int i = PTEDirNextSwapped(&_process->pd, 0); i != ERROR;
+             i = PTEDirNextSwapped(&_process->pd, i + 1)) {
+        SwapDrop(_process, i);
+    }
+}
+
+
+void SwapTrack(pcb_t *_process, int _page_num, int _pfn) {
+    if (!g_owners) {
+        return;
+    }
+    g_owners[_pfn].process    = _process;
+    g_owners[_pfn].page       = _page_num;
+    g_owners[_pfn].referenced = 1;
+}
+
+
+void SwapUntrack(pcb_t *_process, int _page_num, int _pfn) {
+    if (!g_owners) {
+        return;
+    }
+    if (g_owners[_pfn].process == _process && g_owners[_pfn].page == _page_num) {
+        g_owners[_pfn].process = NULL;
+    }
+}
+
+
+int SwapWaitForFrame(pcb_t *_process) {
+    // 1. Frames are freed as soon as their pages are copied out, so if we are out of frames it
+    //    is because every buffer is busy (or nothing can be evicted). Waiting only helps if there
+    //    is a transfer in flight to free a buffer.
+    if (g_swap_mode == SWAP_OFF || !g_disk_start) {
+        return ERROR;
+    }
+    SwapWait(_process);
+    return 0;
+}
+
+
+static int SwapArenaAlloc(int _num_grains) {
+    // 1. First fit: find the first run of _num_grains free grains in the arena and mark it used.
+    int run = 0;
+    for (int i = 0; i < SWAP_ZRAM_GRAINS; i++) {
+        run = (g_arena_map[i / 32] & (1u << (i % 32))) ? 0 : run + 1;
+        if (run == _num_grains) {
+            for (int j = i - _num_grains + 1; j <= i; j++) {
+                g_arena_map[j / 32] |= 1u << (j % 32);
+            }
+            return i - _num_grains + 1;
+        }
+    }
+    return ERROR;
+}
+
+
+static void SwapArenaFree(int _grain, int _num_grains) {
+    for (int i = _grain; i < _grain + _num_grains; i++) {
+        g_arena_map[i / 32] &= ~(1u << (i % 32));
+    }
+}
+
+
+static int SwapClock() {
+    // 1. Sweep the clock hand over physical memory (at most twice, since the first lap may only
+    //    clear reference bits). Only private pages of processes that were preempted in user mode
+    //    (or are sleeping in Delay) are candidates: the kernel never touches their memory until
+    //    they run again, and running again means faulting the page back in. Idle never gives up
+    //    its page, since it can't block.
+    pcb_t *idle = SchedulerGetIdle(e_scheduler);
+    for (int i = 0; i < 2 * e_num_frames; i++) {
+        int pfn      = g_clock_hand;
+        g_clock_hand = (g_clock_hand + 1) % e_num_frames;
+
+        pcb_t *process = g_owners[pfn].process;
+        if (!process || process == idle || !process->preempted || FrameRefCount(pfn) != 1) {
+            continue;
+        }
+        pte_t *pte = ProcessPTEGet(process, g_owners[pfn].page);
+        if (!pte || pte->pfn != pfn) {
+            continue;
+        }
+
+        // 2. Give recently mapped pages a second chance.
+        if (g_owners[pfn].referenced) {
+            g_owners[pfn].referenced = 0;
+            continue;
+        }
+        return pfn;
+    }
+    return ERROR;
+}
+
+
+static int SwapCompress(unsigned char *_src, unsigned char *_dst, int _max_len) {
+    // 1. A small LZ77 codec in the spirit of LZ4. The output is a sequence of ops, each starting
+    //    with a control byte: 0..127 means that many plus one literal bytes follow, and 128..255
+    //    is a match of (c & 127) + SWAP_LZ_MIN_MATCH bytes starting a 16-bit little endian offset
+    //    back. Matches are found through a hash table of the last position each 4-byte sequence
+    //    was seen at; an offset of 1 turns runs of a repeated byte into a few matches.
+    bzero(g_lz_table, sizeof(g_lz_table));
+    int ip  = 0;
+    int op  = 0;
+    int lit = 0;
+    while (ip <= PAGESIZE - SWAP_LZ_MIN_MATCH) {
+        unsigned int seq = _src[ip] | (_src[ip + 1] << 8) | (_src[ip + 2] << 16) |
+                           ((unsigned int) _src[ip + 3] << 24);
+        unsigned int h   = (seq * 2654435761u) >> (32 - SWAP_LZ_HASH_BITS);
+        int cand         = g_lz_table[h] - 1;
+        g_lz_table[h]    = ip + 1;
+        if (cand < 0 || memcmp(_src + cand, _src + ip, SWAP_LZ_MIN_MATCH)) {
+            ip++;
+            continue;
+        }
+
+        // 2. Extend the match as far as it goes (the op format caps its length).
+        int len = SWAP_LZ_MIN_MATCH;
+        while (ip + len < PAGESIZE && len < SWAP_LZ_MIN_MATCH + 127 &&
+               _src[cand + len] == _src[ip + len]) {
+            len++;
+        }
+
+        // 3. Emit the literals before the match, then the match itself.
+        while (lit < ip) {
+            int n = ip - lit > 128 ? 128 : ip - lit;
+            if (op + 1 + n > _max_len) {
+                return ERROR;
+            }
+            _dst[op++] = n - 1;
+            memcpy(_dst + op, _src + lit, n);
+            op  += n;
+            lit += n;
+        }
+        if (op + 3 > _max_len) {
+            return ERROR;
+        }
+        _dst[op++] = 0x80 | (len - SWAP_LZ_MIN_MATCH);
+        _dst[op++] = (ip - cand) & 0xff;
+        _dst[op++] = (ip - cand) >> 8;
+        ip  += len;
+        lit  = ip;
+    }
+
+    // 4. Emit whatever literals are left at the end of the page.
+    while (lit < PAGESIZE) {
+        int n = PAGESIZE - lit > 128 ? 128 : PAGESIZE - lit;
+        if (op + 1 + n > _max_len) {
+            return ERROR;
+        }
+        _dst[op++] = n - 1;
+        memcpy(_dst + op, _src + lit, n);
+        op  += n;
+        lit += n;
+    }
+    return op;
+}
+
+
+static int SwapCopy(int _pfn, char *_buf, int _to_frame) {
+    // 1. Temporarily map the frame to the page right below the kernel stack (making sure the
+    //    kernel heap has not grown into it) and copy the page to or from the buffer through it.
+    int   temp_page_num  = (KERNEL_STACK_BASE >> PAGESHIFT) - 1;
+    void *temp_page_addr = (void *) (temp_page_num << PAGESHIFT);
+    if (temp_page_addr < e_kernel_curr_brk) {
+        TracePrintf(1, "[SwapCopy] Kernel heap overlaps the temporary page\n");
+        return ERROR;
+    }
+    PTESet(e_kernel_pt, temp_page_num, PROT_READ | PROT_WRITE, _pfn);
+    if (_to_frame) {
+        memcpy(temp_page_addr, _buf, PAGESIZE);
+    } else {
+        memcpy(_buf, temp_page_addr, PAGESIZE);
+    }
+    PTEClear(e_kernel_pt, temp_page_num);
+    WriteRegister(REG_TLB_FLUSH, (unsigned int) temp_page_addr);
+    return 0;
+}
+
+
+static int SwapDecompress(unsigned char *_src, int _len, unsigned char *_dst) {
+    // 1. Replay the ops from SwapCompress, checking every length and offset so that a bad
+    //    arena never lets us write outside of the page. Matches may overlap their own output,
+    //    so they have to be copied a byte at a time.
+    int ip = 0;
+    int op = 0;
+    while (ip < _len) {
+        int c = _src[ip++];
+        if (c < 0x80) {
+            int n = c + 1;
+            if (ip + n > _len || op + n > PAGESIZE) {
+                return ERROR;
+            }
+            memcpy(_dst + op, _src + ip, n);
+            ip += n;
+            op += n;
+            continue;
+        }
+        int n = (c & 0x7f) + SWAP_LZ_MIN_MATCH;
+        if (ip + 2 > _len) {
+            return ERROR;
+        }
+        int offset = _src[ip] | (_src[ip + 1] << 8);
+        ip += 2;
+        if (!offset || offset > op || op + n > PAGESIZE) {
+            return ERROR;
+        }
+        for (int i = 0; i < n; i++, op++) {
+            _dst[op] = _dst[op - offset];
+        }
+    }
+    return op == PAGESIZE ? 0 : ERROR;
+}
+
+
+static void SwapDiskStart() {
+    // 1. Ask the disk for the next sector of the transfer at the head of the queue.
+    swap_io_t *io = g_disk_start;
+    DiskAccess(io->op, io->slot * SWAP_SECTORS + io->sector, io->buf + io->sector * SECTORSIZE);
+}
+
+
+static swap_io_t *SwapFindWrite(int _slot) {
+    for (int i = 0; i < SWAP_NUM_BUFFERS; i++) {
+        if (g_ios[i].busy && g_ios[i].op == DISK_WRITE && g_ios[i].slot == _slot) {
+            return &g_ios[i];
+        }
+    }
+    return NULL;
+}
+
+
+static swap_io_t *SwapGetBuffer() {
+    for (int i = 0; i < SWAP_NUM_BUFFERS; i++) {
+        if (!g_ios[i].busy) {
+            return &g_ios[i];
+        }
+    }
+    return NULL;
+}
+
+
+static int SwapGetSlot() {
+    // 1. A slot is free once no page refers to it and it is not still being written to.
+    for (int i = 0; i < g_num_slots; i++) {
+        if (!g_slot_refs[i] && !SwapFindWrite(i)) {
+            return i;
+        }
+    }
+    return ERROR;
+}
+
+
+static void SwapQueue(swap_io_t *_io, int _op, int _slot) {
+    // 1. Fill in the transfer and add it to the end of the disk queue. If the disk is idle,
+    //    start it on the transfer right away.
+    _io->busy   = 1;
+    _io->done   = 0;
+    _io->op     = _op;
+    _io->slot   = _slot;
+    _io->sector = 0;
+    _io->next   = NULL;
+    if (!g_disk_start) {
+        g_disk_start = _io;
+        g_disk_end   = _io;
+        SwapDiskStart();
+        return;
+    }
+    g_disk_end->next = _io;
+    g_disk_end       = _io;
+}
+
+
+static void SwapSlotPut(int _slot) {
+    // 1. Drop a reference to the slot. Once no page refers to it, under zram, give its space in
+    //    the arena back.
+    if (--g_slot_refs[_slot] || g_swap_mode != SWAP_ZRAM) {
+        return;
+    }
+    if (!g_zram[_slot].len) {
+        g_num_zram_zeros--;
+        return;
+    }
+    SwapArenaFree(g_zram[_slot].grain, SWAP_ZRAM_NUM_GRAINS(g_zram[_slot].len));
+    g_num_zram_pages--;
+    g_num_zram_bytes -= g_zram[_slot].len;
+}
+
+
+static void SwapWait(pcb_t *_process) {
+    // 1. Block on the swap wait queue until the next transfer finishes. We are in the middle of
+    //    a trap whose own UserContext stays put on our kernel stack, so KCSwitch only gets a
+    //    scratch copy to restore into when we resume.
+    UserContext uctxt;
+    memcpy(&uctxt, &_process->uctxt, sizeof(UserContext));
+    SchedulerAddSwap(e_scheduler, &g_waiters, _process);
+    KCSwitch(&uctxt, _process);
+}
+
+
+static int SwapZramStore(int _slot) {
+    // 1. All-zero pages (most untouched heap and stack pages) take no space in the arena at all.
+    unsigned int *words = (unsigned int *) g_page_buf;
+    int i = 0;
+    while (i < PAGESIZE / (int) sizeof(unsigned int) && !words[i]) {
+        i++;
+    }
+    if (i == PAGESIZE / (int) sizeof(unsigned int)) {
+        g_zram[_slot].len = 0;
+        g_num_zram_zeros++;
+        return 0;
+    }
+
+    // 2. Otherwise compress the page, giving up if that would not save enough to be worth it,
+    //    and copy it into a run of free grains in the arena.
+    int len = SwapCompress((unsigned char *) g_page_buf, (unsigned char *) g_comp_buf,
+                           SWAP_ZRAM_MAX_LEN);
+    if (len == ERROR) {
+        return ERROR;
+    }
+    int grain = SwapArenaAlloc(SWAP_ZRAM_NUM_GRAINS(len));
+    if (grain == ERROR) {
+        return ERROR;
+    }
+    memcpy(g_arena + grain * SWAP_ZRAM_GRAIN, g_comp_buf, len);
+    g_zram[_slot].grain = grain;
+    g_zram[_slot].len   = len;
+    g_num_zram_pages++;
+    g_num_zram_bytes += len;
+    return 0;
+}
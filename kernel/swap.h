@@ -0,0 +1,147 @@
+#ifndef __SWAP_H
+#define __SWAP_H
+#include <hardware.h>
+#include "process.h"
+
+// Swap modes, selected at boot with the "swap=" flag (see KernelParseBootFlags)
+#define SWAP_OFF          0
+#define SWAP_DISK         1
+#define SWAP_ZRAM         2
+
+// A swapped out page takes SWAP_SECTORS consecutive disk sectors (a "slot"), so the disk holds
+// SWAP_NUM_SLOTS pages. Pages are copied into one of SWAP_NUM_BUFFERS kernel bounce buffers to
+// be written out (or read back in), which bounds the number of page transfers in flight.
+#define SWAP_SECTORS      (PAGESIZE / SECTORSIZE)
+#define SWAP_NUM_SLOTS    (NUMSECTORS / SWAP_SECTORS)
+#define SWAP_NUM_BUFFERS  4
+
+// Without a disk, pages are compressed into an arena of SWAP_ZRAM_ARENA_PAGES kernel pages that
+// is allocated at boot and handed out in SWAP_ZRAM_GRAIN byte grains. All-zero pages take no
+// space at all, and a page that does not compress to SWAP_ZRAM_MAX_LEN bytes or less is left
+// resident (SwapEvict tries up to SWAP_ZRAM_TRIES victims for one that does).
+#define SWAP_ZRAM_ARENA_PAGES     8
+#define SWAP_ZRAM_GRAIN           64
+#define SWAP_ZRAM_GRAINS          (SWAP_ZRAM_ARENA_PAGES * PAGESIZE / SWAP_ZRAM_GRAIN)
+#define SWAP_ZRAM_NUM_GRAINS(len) (((len) + SWAP_ZRAM_GRAIN - 1) / SWAP_ZRAM_GRAIN)
+#define SWAP_ZRAM_MAX_LEN         (PAGESIZE / 2)
+#define SWAP_ZRAM_SLOTS           1024
+#define SWAP_ZRAM_TRIES           8
+#define SWAP_MAX_SLOTS            SWAP_ZRAM_SLOTS
+
+// The LZ codec used for zram (see SwapCompress) hashes 4-byte sequences into a table of
+// 2^SWAP_LZ_HASH_BITS entries to find matches, which are at least SWAP_LZ_MIN_MATCH bytes long.
+#define SWAP_LZ_HASH_BITS         12
+#define SWAP_LZ_MIN_MATCH         4
+
+
+/*!
+ * \desc              Sets the swap mode and allocates the structures swapping needs. Must be
+ *                    called at boot, before the kernel's page table is set up.
+ *
+ * \param[in] _mode   "disk" to swap to the disk, "zram" to compress pages in memory, or "off"
+ *
+ * \return            0 on success, ERROR otherwise.
+ */
+int SwapInit(char *_mode);
+
+
+/*!
+ * \desc              Called by TrapDisk when the disk finishes a sector. Starts the next sector
+ *                    (or the next queued page transfer) and wakes processes waiting on swap.
+ *
+ * \return            0 on success, ERROR otherwise.
+ */
+int SwapDiskDone(void);
+
+
+/*!
+ * \desc              Picks a victim page with the clock algorithm, copies it out to be written
+ *                    to disk (or compresses it into the zram arena), and frees its frame. Called
+ *                    by the frame allocator when it runs out of free frames.
+ *
+ * \return            0 on success (a frame was freed), ERROR otherwise.
+ */
+int SwapEvict(void);
+
+
+/*!
+ * \desc                 Drops a single swapped out page of a process (e.g., when the heap shrinks).
+ */
+void SwapDrop(pcb_t *_process, int _page_num);
+
+
+/*!
+ * \desc                 Gives a child the parent's swapped out pages after a fork. The two
+ *                       share each page's swap slot until one of them swaps it back in.
+ *
+ * \param[in] _parent    The pcb for the parent process
+ * \param[in] _child     The pcb for the new child process
+ *
+ * \return               0 on success, ERROR if the child's page directory could not grow (the
+ *                       pages shared so far are dropped along with the child).
+ */
+int SwapFork(pcb_t *_parent, pcb_t *_child);
+
+
+/*!
+ * \desc                 Swaps a page of the current running process back in, blocking the
+ *                       process until the page has been read from the disk (zram pages are
+ *                       simply decompressed).
+ *
+ * \param[in] _process   The pcb for the current running process
+ * \param[in] _page_num  The region 1 page number of the swapped out page
+ *
+ * \return               0 on success, ERROR otherwise.
+ */
+int SwapIn(pcb_t *_process, int _page_num);
+
+
+/*!
+ * \desc                  Looks up the process page that a frame was last mapped to (see SwapTrack).
+ *
+ * \param[in]  _pfn       The frame number
+ * \param[out] _page_num  Where to store the region 1 page number the frame is mapped to
+ *
+ * \return                The pcb of the process mapping the frame, NULL if it is not mapped.
+ */
+pcb_t *SwapGetOwner(int _pfn, int *_page_num);
+
+
+/*!
+ * \desc                 Returns whether a page of a process is currently swapped out.
+ */
+int SwapIsSwapped(pcb_t *_process, int _page_num);
+
+
+/*!
+ * \desc                 Prints the swap counters with TracePrintf: pages swapped out and in, the
+ *                       average and worst fault-in latency in clock ticks and, under zram, the
+ *                       pages held in the arena and their compression ratio.
+ */
+void SwapPrintStats(void);
+
+
+/*!
+ * \desc                 Drops all of a process' swapped out pages (e.g., on exit or exec).
+ */
+void SwapRelease(pcb_t *_process);
+
+
+/*!
+ * \desc                 Records which process page a frame is mapped to (so the clock can find
+ *                       the page to evict for a frame), or forgets it once it is unmapped.
+ */
+void SwapTrack(pcb_t *_process, int _page_num, int _pfn);
+void SwapUntrack(pcb_t *_process, int _page_num, int _pfn);
+
+
+/*!
+ * \desc                 Blocks the current running process until a page transfer finishes, if
+ *                       any are in flight, so that a failed frame allocation can be retried.
+ *
+ * \param[in] _process   The pcb for the current running process
+ *
+ * \return               0 if the process waited (retry), ERROR if waiting would not help.
+ */
+int SwapWaitForFrame(pcb_t *_process);
+#endif // __SWAP_H
@@ -11,6 +11,7 @@
 #include "syscall.h"
 #include "bitvec.h"
 #include "semaphore.h"
+#include "swap.h"
 
 /*!
  * \desc                Fork a new process based on the caller process's current setup
@@ -26,43 +27,51 @@ int SyscallFork (UserContext *_uctxt) {
         TracePrintf(1, "SyscallFork: failed to create a new process.\n");
         return ERROR;
     }
-    SchedulerAddProcess(e_scheduler, child);
     // Copy user_context into the new pcb
     memcpy(&child->uctxt, _uctxt, sizeof(UserContext));
-    // For each valid pte in the page table of the parent process, find a free frame and change the page table entry to map into this frame
+    // Share each of the parent's valid pages with the child copy-on-write rather than copying
+    // them now: both page tables map the same frame (so bump its reference count), and any
+    // writable page is made read-only in both processes. The first write to such a page traps
+    // into TrapMemory, which gives the writer its own copy (see ProcessCopyOnWrite). If the
+    // child's page directory can not grow (the kernel heap is full), throw the child away and
+    // fail the fork; the parent's pages simply stay copy-on-write until it next writes them.
     pcb_t *parent = SchedulerGetRunning(e_scheduler);
-    for (int i = 0; i < MAX_PT_LEN; i++) {
-        if (parent->pt[i].valid) {
-            int pfn = FrameFindAndSet();
-            if (pfn == ERROR) {
-                TracePrintf(1, "SyscallFork: failed to find a free frame.\n");
-                ProcessDestroy(child);
-                return ERROR;
-            }
-            PTESet(child->pt, i, (int) parent->pt[i].prot, pfn);
-            // Copy the frame stack to a new frame stack by temporarily mapping the destination frame into some page
-            // E.g, the page right below the kernel stack.
-            void *src_addr = (void *) ((i << PAGESHIFT) + VMEM_1_BASE);
-            int temp_page_num = (KERNEL_STACK_BASE >> PAGESHIFT) - 1;
-            // Assert kernel heap is at least one page below kernel stack
-            void *temp_page_addr = (void *) (temp_page_num << PAGESHIFT);
-            if (temp_page_addr < e_kernel_curr_brk) {
-                TracePrintf(1, "SyscallFork: unable to use the frame below kernel stack as a temporary.\n");
-                ProcessDestroy(child);
-                return ERROR;
-            }
-            // Copy the frame from parent to child
-            PTESet(e_kernel_pt, temp_page_num, PROT_READ|PROT_WRITE, pfn);
-            memcpy(temp_page_addr, src_addr, PAGESIZE);
-            PTEClear(e_kernel_pt, temp_page_num);
-            WriteRegister(REG_TLB_FLUSH, TLB_FLUSH_0);
+    for (int i = ProcessPTENext(parent, 0); i != ERROR; i = ProcessPTENext(parent, i + 1)) {
+        pte_t *pte = ProcessPTEGet(parent, i);
+        if (pte->prot & PROT_WRITE) {
+            ProcessPTEUpdate(parent, i, pte->prot & ~PROT_WRITE, pte->pfn);
+            ProcessPTESetCOW(parent, i, 1);
+        }
+        if (ProcessPTESet(child, i, (int) pte->prot, pte->pfn) == ERROR) {
+            TracePrintf(1, "SyscallFork: failed to map page %d for the child.\n", i);
+            WriteRegister(REG_TLB_FLUSH, TLB_FLUSH_1);
+            ProcessDestroy(child);
+            return ERROR;
         }
+        FrameRef(pte->pfn);
+        ProcessPTESetCOW(child, i, ProcessPTEGetCOW(parent, i));
     }
+    // Program pages the parent has not touched yet are not in its page table, so let the child
+    // demand load them from the same executable.
+    LoadProgramShare(parent, child);
+    // The parent's writable pages just became read-only, so flush its region 1 translations.
+    WriteRegister(REG_TLB_FLUSH, TLB_FLUSH_1);
+    // Likewise, pages the parent has swapped out are not in its page table either, so let the
+    // child share their swap slots.
+    if (SwapFork(parent, child) == ERROR) {
+        TracePrintf(1, "SyscallFork: failed to share swapped out pages with the child.\n");
+        ProcessDestroy(child);
+        return ERROR;
+    }
+    SchedulerAddProcess(e_scheduler, child);
     // Setup relationship between parent/child
     ProcessAddChild(parent, child);
     child->parent   = parent;
     child->brk      = parent->brk;
     child->data_end = parent->data_end;
+    child->priority = parent->priority;
+    child->pass     = parent->pass;
+    SchedulerSetTickets(e_scheduler, child, parent->tickets);
     // Add child to ready list
     SchedulerAddReady(e_scheduler, child);
 
@@ -95,7 +104,7 @@ int SyscallFork (UserContext *_uctxt) {
  */
 int SyscallExec (UserContext *_uctxt, char *_filename, char **_argvec) {
     // 1. Check filename argument for NULL
-    if (!_filename || !_argvec || !_argvec[0]) {
+    if (!_filename || !_argvec) {
         TracePrintf(1, "[SyscallExec] One or more invalid arguments\n");
         return ERROR;
     }
@@ -108,37 +117,44 @@ int SyscallExec (UserContext *_uctxt, char *_filename, char **_argvec) {
         Halt();
     }
 
-    // 3. Calculate the length of the filename string and then check that it is within valid
-    //    region 1 memory space for the current running process. Specifically, check that every
-    //    byte is within region 1 and that they are in pages that have valid protections.
-    int length = 0;
-    while (_filename[length] != '\0') { length++; }
-    int ret = PTECheckAddress(running->pt,
-                     (void *) _filename,
-                              length,
-                              PROT_READ);
+    // 3. Check that the filename string is within valid region 1 memory space for the current
+    //    running process. Specifically, check that every byte is within region 1 and that they
+    //    are in pages that have valid protections. The string may live in a program page that
+    //    has not been loaded yet, so ProcessCheckString checks it a page at a time rather than
+    //    us running off the end of a page looking for its terminating NUL.
+    int ret = ProcessCheckString(running, _filename);
     if (ret < 0) {
         TracePrintf(1, "[SyscallExec] Filename is not within valid address space\n");
-        PTEPrint(running->pt);
+        PTEPrint(ProcessPTELoad(running));
         Halt();
     }
 
-    // 4. Calculate the number of arguments. For each argument, calculate its length then check
-    //    that it is within valid region 1 memory space.
+    // 4. Calculate the number of arguments, checking each argv pointer before we read it. For
+    //    each argument, check that the string is within valid region 1 memory space.
     int num_args = 0;
-    if (_argvec) {
-        while (_argvec[num_args]) { num_args++; }
+    while (1) {
+        ret = ProcessCheckAddress(running,
+                         (void *) &_argvec[num_args],
+                                  sizeof(char *),
+                                  PROT_READ);
+        if (ret < 0) {
+            TracePrintf(1, "[SyscallExec] Argvec is not within valid address space\n");
+            return ERROR;
+        }
+        if (!_argvec[num_args]) {
+            break;
+        }
+        num_args++;
+    }
+    if (!num_args) {
+        TracePrintf(1, "[SyscallExec] Argvec has no arguments\n");
+        return ERROR;
     }
     for (int i = 0; i < num_args; i++) {
-        length = 0;
-        while (_argvec[i][length] != '\0') { length++; }
-        ret = PTECheckAddress(running->pt,
-                     (void *) _argvec[i],
-                              length,
-                              PROT_READ);
+        ret = ProcessCheckString(running, _argvec[i]);
         if (ret < 0) {
             TracePrintf(1, "[SyscallExec] Argvec[%d] is not within valid address space\n", i);
-            PTEPrint(running->pt);
+            PTEPrint(ProcessPTELoad(running));
             Halt();
         }
     }
@@ -222,6 +238,7 @@ void SyscallExit (UserContext *_uctxt, int _status) {
     SchedulerPrintTerminated(e_scheduler);
     SchedulerPrintWait(e_scheduler);
     SchedulerPrintReady(e_scheduler);
+    SlabPrint(NULL);
 
     // 5. The guide states that this call should never return. Thus, we should context switch
     //    to the next ready process. Since the exited process is now in the terminated list,
@@ -249,10 +266,10 @@ int SyscallWait (UserContext *_uctxt, int *_status_ptr) {
     //    cannot pass us an address of the last byte of a valid page in hopes of writing to the
     //    next (potentially invalid) page because an integer is larger than a byte.
     if (_status_ptr != NULL) {
-        int ret = PTECheckAddress(running->pt,
-                                  (void *) _status_ptr,
-                                  sizeof(int),
-                                  PROT_READ | PROT_WRITE);
+        int ret = ProcessCheckAddress(running,
+                                      (void *) _status_ptr,
+                                      sizeof(int),
+                                      PROT_READ | PROT_WRITE);
         if (ret < 0) {
             TracePrintf(1, "[SyscallWait] Status pointer is not within valid address space\n");
             return ERROR;
@@ -284,6 +301,7 @@ int SyscallWait (UserContext *_uctxt, int *_status_ptr) {
                 if (_status_ptr) {
                     *_status_ptr = child->exit_status;
                 }
+                SchedulerRemoveProcess(e_scheduler, child_pid);
                 ProcessDelete(child);
                 return child_pid;
             }
@@ -374,30 +392,52 @@ int SyscallBrk (UserContext *_uctxt, void *_brk) {
     for (int i = 0; i < num_pages; i++) {
 
         if (growing) {
-            // 6a. If we are growing the heap, then we first need to find an available frame.
-            //     If we can't find one (i.e., we are out of memory) return ERROR.
-            int frame_num = FrameFindAndSet();
+            // 6a. If we are growing the heap, then we first need to find an available (zeroed)
+            //     frame, waiting on the swapper if it is busy freeing some.
+            //
+            // 6b. Map the frame to a page in the process' page table. Specifically, start with the
+            //     current page pointed to by the process brk. If the page table can not grow to
+            //     hold the page (the kernel heap is full), give the frame back.
+            int frame_num;
+            while ((frame_num = FrameAllocZero()) == ERROR && SwapWaitForFrame(running) == 0) {}
             if (frame_num == ERROR) {
                 TracePrintf(1, "[SyscallBrk] Unable to find free frame\n");
-                return ERROR;
+            } else if (ProcessPTESet(running,                   // process
+                                     cur_brk_page_num + i,      // page number
+                                     PROT_READ | PROT_WRITE,    // page protection bits
+                                     frame_num) == ERROR) {     // frame number
+                TracePrintf(1, "[SyscallBrk] Unable to map page: %d\n", cur_brk_page_num + i);
+                FrameClear(frame_num);
+                frame_num = ERROR;
             }
 
-            // 6b. Map the frame to a page in the process' page table. Specifically, start with the
-            //     current page pointed to by the process brk. Afterwards, mark the frame as in use.
-            PTESet(running->pt,             // page table pointer
-                   cur_brk_page_num + i,    // page number
-                   PROT_READ | PROT_WRITE,  // page protection bits
-                   frame_num);              // frame number
+            // 6c. If we are out of memory, unmap the pages we already added (so that the page
+            //     table still matches the unchanged brk) and return ERROR.
+            if (frame_num == ERROR) {
+                for (int j = 0; j < i; j++) {
+                    FrameClear(ProcessPTEGet(running, cur_brk_page_num + j)->pfn);
+                    ProcessPTEClear(running, cur_brk_page_num + j);
+                }
+                return ERROR;
+            }
             TracePrintf(1, "[SyscallBrk] Mapping page: %d to frame: %d\n",
                            cur_brk_page_num + i, frame_num);
         } else {
-            // 6c. If we are shrinking the heap, then we need to unmap pages. Start by grabbing
+            // 6d. If we are shrinking the heap, then we need to unmap pages. A page that was
+            //     swapped out only needs its swap slot dropped. Otherwise, start by grabbing
             //     the number of the frame mapped to the current brk page. Free the frame.
-            int frame_num = running->pt[cur_brk_page_num - i].pfn;
+            if (SwapIsSwapped(running, cur_brk_page_num - i)) {
+                SwapDrop(running, cur_brk_page_num - i);
+                continue;
+            }
+            int frame_num = ProcessPTEGet(running, cur_brk_page_num - i)->pfn;
             FrameClear(frame_num);
 
-            // 6d. Clear the page in the process' page table so it is no longer valid
-            PTEClear(running->pt, cur_brk_page_num - i);
+            // 6e. Clear the page in the process' page table so it is no longer valid, and flush
+            //     just that page from the TLB (growing never leaves a stale entry behind).
+            ProcessPTEClear(running, cur_brk_page_num - i);
+            WriteRegister(REG_TLB_FLUSH,
+                          (unsigned int) (VMEM_1_BASE + ((cur_brk_page_num - i) << PAGESHIFT)));
             TracePrintf(1, "[SyscallBrk] Unmapping page: %d from frame: %d\n",
                            cur_brk_page_num - i, frame_num);
         }
@@ -409,7 +449,6 @@ int SyscallBrk (UserContext *_uctxt, void *_brk) {
     TracePrintf(1, "[SyscallBrk] _brk:              %p\n", _brk);
     TracePrintf(1, "[SyscallBrk] running->brk:      %p\n", running->brk);
     running->brk = _brk;
-    WriteRegister(REG_TLB_FLUSH, TLB_FLUSH_ALL);
     return 0;
 }
 
@@ -445,7 +484,12 @@ int SyscallDelay (UserContext *_uctxt, int _clock_ticks) {
     TracePrintf(1, "[SyscallDelay] Blocking process %d for %d clock cycles\n",
                    running_old->pid, _clock_ticks);
 
-    return KCSwitch(_uctxt, running_old);
+    // 4. Nothing in the kernel touches a sleeping process' pages, so while it sleeps it counts as
+    //    preempted, which lets the swapper evict its pages and idle merge them.
+    running_old->preempted = 1;
+    int rc = KCSwitch(_uctxt, running_old);
+    running_old->preempted = 0;
+    return rc;
 }
 
 /**
@@ -472,4 +516,170 @@ int SyscallReclaim(int id) {
         return SemReclaim(id);
     else
         return ERROR;
-}
\ No newline at end of file
+}
+
+
+/*!
+ * \desc                Sets the scheduling priority of a process. A process may only change its own
+ *                      priority or the priority of one of its children. A process may lower its
+ *                      own priority but never raise it, since that would undo MLFQ demotion. A
+ *                      parent may raise a child's priority, but no higher than its own.
+ *
+ * \param[in] _pid       The pid of the process to change, or 0 for the calling process
+ * \param[in] _priority  The new priority level (0 is the highest priority)
+ *
+ * \return              0 on success, ERROR otherwise
+ */
+int SyscallSetPriority (int _pid, int _priority) {
+    // 1. Get the current running process.
+    pcb_t *running = SchedulerGetRunning(e_scheduler);
+    if (!running) {
+        TracePrintf(1, "[SyscallSetPriority] e_scheduler returned no running process\n");
+        Halt();
+    }
+
+    // 2. Look up the target process and make sure the caller is allowed to change it.
+    pcb_t *process = _pid ? SchedulerGetProcess(e_scheduler, _pid) : running;
+    if (!process || process->exited) {
+        TracePrintf(1, "[SyscallSetPriority] Process %d not found\n", _pid);
+        return ERROR;
+    }
+    if (process != running && process->parent != running) {
+        TracePrintf(1, "[SyscallSetPriority] Process %d may not change process %d\n",
+                       running->pid, process->pid);
+        return ERROR;
+    }
+
+    // 3. Lower numbers are higher priorities. Callers may always lower a priority, but may only
+    //    raise a child's and never above their own (otherwise a cpu-bound process could keep
+    //    putting itself, or a child doing its work, back at the top level).
+    if (_priority < process->priority && (process == running || _priority < running->priority)) {
+        TracePrintf(1, "[SyscallSetPriority] Process %d may not raise process %d to priority %d\n",
+                       running->pid, process->pid, _priority);
+        return ERROR;
+    }
+    return SchedulerSetPriority(e_scheduler, process, _priority);
+}
+
+
+/*!
+ * \desc                Returns the current scheduling priority of a process.
+ *
+ * \param[in] _pid      The pid of the process to query, or 0 for the calling process
+ *
+ * \return              The process' priority level on success, ERROR otherwise
+ */
+int SyscallGetPriority (int _pid) {
+    // 1. Get the current running process.
+    pcb_t *running = SchedulerGetRunning(e_scheduler);
+    if (!running) {
+        TracePrintf(1, "[SyscallGetPriority] e_scheduler returned no running process\n");
+        Halt();
+    }
+
+    // 2. Look up the target process and return its priority.
+    pcb_t *process = _pid ? SchedulerGetProcess(e_scheduler, _pid) : running;
+    if (!process || process->exited) {
+        TracePrintf(1, "[SyscallGetPriority] Process %d not found\n", _pid);
+        return ERROR;
+    }
+    return process->priority;
+}
+
+
+/*!
+ * \desc                Sets the number of stride scheduling tickets a process holds. Under the
+ *                      "stride" policy a process gets cpu time in proportion to its tickets. A
+ *                      process may only change its own tickets or the tickets of its children. As
+ *                      with priorities, a process may give up tickets but never add to its own,
+ *                      and a parent may raise a child's tickets, but no higher than its own.
+ *
+ * \param[in] _pid      The pid of the process to change, or 0 for the calling process
+ * \param[in] _tickets  The new number of tickets (1 to SCHEDULER_MAX_TICKETS)
+ *
+ * \return              0 on success, ERROR otherwise
+ */
+int SyscallSetTickets (int _pid, int _tickets) {
+    // 1. Get the current running process.
+    pcb_t *running = SchedulerGetRunning(e_scheduler);
+    if (!running) {
+        TracePrintf(1, "[SyscallSetTickets] e_scheduler returned no running process\n");
+        Halt();
+    }
+
+    // 2. Look up the target process and make sure the caller is allowed to change it.
+    pcb_t *process = _pid ? SchedulerGetProcess(e_scheduler, _pid) : running;
+    if (!process || process->exited) {
+        TracePrintf(1, "[SyscallSetTickets] Process %d not found\n", _pid);
+        return ERROR;
+    }
+    if (process != running && process->parent != running) {
+        TracePrintf(1, "[SyscallSetTickets] Process %d may not change process %d\n",
+                       running->pid, process->pid);
+        return ERROR;
+    }
+
+    // 3. Callers may always lower a process' tickets, but may only raise a child's and never
+    //    above their own (otherwise any process could take over the cpu under stride scheduling).
+    if (_tickets > process->tickets && (process == running || _tickets > running->tickets)) {
+        TracePrintf(1, "[SyscallSetTickets] Process %d may not raise process %d to %d tickets\n",
+                       running->pid, process->pid, _tickets);
+        return ERROR;
+    }
+    return SchedulerSetTickets(e_scheduler, process, _tickets);
+}
+
+
+/*!
+ * \desc                Creates a child process that runs in the caller's region 1 itself, rather
+ *                      than in a copy-on-write copy of it, while the caller blocks. The caller
+ *                      resumes once the child calls Exec or Exit, which gives region 1 back. Only
+ *                      a pcb and a kernel stack are allocated, so spawning a new program this way
+ *                      is much cheaper than with Fork. The child must not return from the function
+ *                      that called Vfork, since it shares the caller's stack.
+ *
+ * \param[in] _uctxt    current UserContext
+ *
+ * \return              Child's pid for the parent, 0 for the child, and ERROR otherwise
+ */
+int SyscallVfork (UserContext *_uctxt) {
+    // 1. Get the current running process and create a pcb (and kernel stack) for the child, with
+    //    the same scheduling state and parent/child links that Fork sets up.
+    pcb_t *parent = SchedulerGetRunning(e_scheduler);
+    if (!parent) {
+        TracePrintf(1, "[SyscallVfork] e_scheduler returned no running process\n");
+        Halt();
+    }
+    pcb_t *child = ProcessCreate();
+    if (!child) {
+        TracePrintf(1, "[SyscallVfork] Failed to create a new process\n");
+        return ERROR;
+    }
+    SchedulerAddProcess(e_scheduler, child);
+    memcpy(&child->uctxt, _uctxt, sizeof(UserContext));
+    ProcessAddChild(parent, child);
+    child->parent   = parent;
+    child->priority = parent->priority;
+    child->pass     = parent->pass;
+    SchedulerSetTickets(e_scheduler, child, parent->tickets);
+
+    // 2. Hand our region 1 to the child as is (no frames are shared or copied), make the child
+    //    ready, and copy our kernel stack into the child's so that it resumes from here too.
+    ProcessVforkLend(parent, child);
+    SchedulerAddReady(e_scheduler, child);
+    if (KernelContextSwitch(KCCopy, child, NULL) == ERROR) {
+        TracePrintf(1, "[SyscallVfork] KernelContextSwitch failed\n");
+        Halt();
+    }
+    if (SchedulerGetRunning(e_scheduler) == child) {
+        return 0;
+    }
+
+    // 3. We have no region 1 until the child Execs or Exits, so block until it gives it back.
+    //    Grab the child's pid first, since it may be gone by the time we run again.
+    int child_pid = child->pid;
+    memcpy(&parent->uctxt, _uctxt, sizeof(UserContext));
+    SchedulerAddVfork(e_scheduler, &child->vfork_queue, parent);
+    KCSwitch(_uctxt, parent);
+    return child_pid;
+}
@@ -1,6 +1,14 @@
 #ifndef __SYSCALL_H
 #define __SYSCALL_H
 
+// Syscall codes for our kernel specific syscalls (these are not defined by yalnix.h, and user
+// programs reach them through the wrappers in user/yuser_ext.h)
+#define YALNIX_SET_PRIORITY 0x70
+#define YALNIX_GET_PRIORITY 0x71
+#define YALNIX_SET_TICKETS  0x72
+#define YALNIX_VFORK        0x73
+#define YALNIX_PIPE_INIT_SIZED 0x74
+
 
 /*!
  * \desc    a
@@ -35,4 +43,12 @@ int SyscallDelay (UserContext *_uctxt, int _clock_ticks);
 
 int SyscallReclaim(int id);
 
+int SyscallSetPriority (int _pid, int _priority);
+
+int SyscallGetPriority (int _pid);
+
+int SyscallSetTickets (int _pid, int _tickets);
+
+int SyscallVfork (UserContext *_uctxt);
+
 #endif
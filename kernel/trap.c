@@ -8,6 +8,8 @@
 #include "lock.h"
 #include "kernel.h"
 #include "pipe.h"
+#include "load_program.h"
+#include "merge.h"
 #include "process.h"
 #include "pte.h"
 #include "scheduler.h"
@@ -15,6 +17,7 @@
 #include "trap.h"
 #include "tty.h"
 #include "semaphore.h"
+#include "swap.h"
 
 
 /*!
@@ -137,6 +140,25 @@ int TrapKernel(UserContext *_uctxt) {
         case YALNIX_SEM_DOWN:
             _uctxt->regs[0] = SemDown(_uctxt, (int)_uctxt->regs[0]);
             break;
+        case YALNIX_SET_PRIORITY:
+            _uctxt->regs[0] = SyscallSetPriority((int) _uctxt->regs[0],     // pid (0 for self)
+                                                 (int) _uctxt->regs[1]);    // new priority
+            break;
+        case YALNIX_GET_PRIORITY:
+            _uctxt->regs[0] = SyscallGetPriority((int) _uctxt->regs[0]);    // pid (0 for self)
+            break;
+        case YALNIX_SET_TICKETS:
+            _uctxt->regs[0] = SyscallSetTickets((int) _uctxt->regs[0],      // pid (0 for self)
+                                                (int) _uctxt->regs[1]);     // new tickets
+            break;
+        case YALNIX_VFORK:
+            _uctxt->regs[0] = SyscallVfork(_uctxt);
+            break;
+        case YALNIX_PIPE_INIT_SIZED:
+            _uctxt->regs[0] = PipeInitSized(e_pipe_list,              // declared in kernel.h
+                                            (int *) _uctxt->regs[0],  // where to store the id
+                                            (int) _uctxt->regs[1]);   // capacity in bytes
+            break;
 
         default: break;
     }
@@ -145,12 +167,15 @@ int TrapKernel(UserContext *_uctxt) {
 
 
 /*!
- * \desc              This handler gets called every time the clock interrupt fires---the time
- *                    between clock interrupts is the amount of time (i.e., quantum) that a process
- *                    gets to run for before being switched out. Before switching out the current
- *                    process, this handler updates our delay list (i.e., moves processes to the
- *                    ready list if they hit their delay value) and saves the current process'
- *                    UserContext in its pcb for future use.
+ * \desc              This handler gets called every time the clock interrupt fires. The scheduling
+ *                    policy decides whether the current process is switched out: under round
+ *                    robin and stride every tick, and under MLFQ a process at priority level L
+ *                    gets SCHEDULER_QUANTUM(L) ticks (or less if a higher priority process becomes
+ *                    ready). If nothing else is runnable, the current process simply keeps running
+ *                    without touching the ready lists or saving its UserContext. Before switching
+ *                    out the current process, this handler updates our delay list (i.e., moves
+ *                    processes to the ready list if they hit their delay value) and saves the
+ *                    current process' UserContext in its pcb for future use.
  * 
  * \param[in] _uctxt  The UserContext for the process associated with the TRAP
  * 
@@ -164,23 +189,43 @@ int TrapClock(UserContext *_uctxt) {
     }
 
     // 2. Update any processes that are currently blocked due to a delay call. This will
-    //    loop over blocked list and decrement the clock_count for any processes delaying.
-    //    If their count hits zero, they get added to the ready queue.
+    //    advance the delay wheel and add any processes whose delay is up to the ready queue.
+    //    Then age the ready queues so that demoted processes do not starve.
     SchedulerUpdateDelay(e_scheduler);
+    SchedulerUpdateAging(e_scheduler);
 
-    // 3. Get the pcb for the current running process and the next process to run. If there is
-    //    not process in the ready queue, simply return and don't bother context switching.
+    // 3. Get the pcb for the current running process.
     pcb_t *running_old = SchedulerGetRunning(e_scheduler);
     if (!running_old) {
         TracePrintf(1, "[TrapClock] e_scheduler returned no running process\n");
         Halt();
     }
 
-    // 4. Save the UserContext for the current running process in its pcb and add it to the ready
+    // 4. If we interrupted idle, the machine has nothing better to do, so spend some of this tick
+    //    zeroing free frames ahead of time for future stack, bss, and heap pages, and merging
+    //    duplicate pages to free up frames.
+    if (running_old == SchedulerGetIdle(e_scheduler)) {
+        FrameZeroIdle();
+        MergeIdle();
+    }
+
+    // 5. Charge the current process for this tick. If the scheduling policy says it should keep
+    //    running (e.g., it still has quantum left at its MLFQ level), or if there is nothing else
+    //    to run, let it keep running. This fast path skips the ready lists and UserContext copies
+    //    entirely, which is the common case when a single job (or just idle) is running.
+    if (!SchedulerUpdateQuantum(e_scheduler, running_old) || !SchedulerHasReady(e_scheduler)) {
+        return 0;
+    }
+
+    // 6. Save the UserContext for the current running process in its pcb and add it to the ready
     //    list. Then call our context switch function to switch to the next ready process.
+    //    Mark the process as preempted while it waits, which lets the swapper evict its pages.
     memcpy(&running_old->uctxt, _uctxt, sizeof(UserContext));
     SchedulerAddReady(e_scheduler, running_old);
-    return KCSwitch(_uctxt, running_old);
+    running_old->preempted = 1;
+    int rc = KCSwitch(_uctxt, running_old);
+    running_old->preempted = 0;
+    return rc;
 }
 
 
@@ -213,9 +258,11 @@ int TrapIllegal(UserContext *_uctxt) {
  * \desc              This handler gets called when the process executes an illegal memory access,
  *                    which may be due to (1) violating page protection permissions (2) accessing
  *                    outside of the processes allowed memory or (3) accessing allowed but unmapped
- *                    memory (i.e., when the stack grows into an unmapped page). For the first two
- *                    cases, we simply print debug information and exit the process. For the third,
- *                    we need to allocate space to allow the stack to grow.
+ *                    memory (i.e., when the stack grows into an unmapped page). A permissions fault
+ *                    on a copy-on-write page is resolved by copying that page, and a fault on a
+ *                    program page that has not been demand loaded yet by loading it. For the
+ *                    first two cases, we simply print debug information and exit the process. For
+ *                    the third, we need to allocate space to allow the stack to grow.
  *                     
  * \param[in] _uctxt  The UserContext for the process associated with the TRAP
  * 
@@ -227,54 +274,97 @@ int TrapMemory(UserContext *_uctxt) {
         return ERROR;
     }
 
-    // 2. If the memory fault was due to invalid permissions, simply abort the process.
-    if (_uctxt->code == YALNIX_ACCERR) {
-        TracePrintf(1, "[TrapMemory] Invalid permissions: %p\n", _uctxt->addr);
-        SyscallExit(_uctxt, ERROR);
-    }
-
-    // 3. Grab the pcb for the current running process
+    // 2. Grab the pcb for the current running process
     pcb_t *running_old = SchedulerGetRunning(e_scheduler);
     if (!running_old) {
         TracePrintf(1, "[TrapClock] e_scheduler returned no running process\n");
         Halt();
     }
 
+    // 3. If the memory fault was due to invalid permissions, check whether the process wrote to
+    //    a page it shares copy-on-write after a fork. If so, give it its own copy of just that
+    //    page and let it retry the write. Otherwise, simply abort the process.
+    if (_uctxt->code == YALNIX_ACCERR) {
+        int page_num = PTEAddressToPage(_uctxt->addr) - MAX_PT_LEN;
+        if (page_num >= 0 && page_num < MAX_PT_LEN && ProcessPTEGetCOW(running_old, page_num)) {
+            if (ProcessCopyOnWrite(running_old, page_num) == ERROR) {
+                TracePrintf(1, "[TrapMemory] Failed to copy page: %d\n", page_num);
+                SyscallExit(_uctxt, ERROR);
+            }
+            memcpy(&running_old->uctxt, _uctxt, sizeof(UserContext));
+            return SUCCESS;
+        }
+        TracePrintf(1, "[TrapMemory] Invalid permissions: %p\n", _uctxt->addr);
+        SyscallExit(_uctxt, ERROR);
+    }
+
     // 4. If the fault was not due to invalid permissions, then its due to the address pointing
-    //    to an unmapped page. Check to see if this unmapped page is between the heap and stack
+    //    to an unmapped page. First check if the page was swapped out, and if so swap it back in.
+    //    Program text and data pages are demand loaded, so then check if this is one of them
+    //    that has not been touched yet. If so, load it. Either way, let the process retry.
+    int fault_pn = PTEAddressToPage(_uctxt->addr) - MAX_PT_LEN;
+    if (SwapIsSwapped(running_old, fault_pn)) {
+        if (SwapIn(running_old, fault_pn) == ERROR) {
+            TracePrintf(1, "[TrapMemory] Failed to swap in page: %d\n", fault_pn);
+            SyscallExit(_uctxt, ERROR);
+        }
+        memcpy(&running_old->uctxt, _uctxt, sizeof(UserContext));
+        return SUCCESS;
+    }
+    if (LoadProgramHasPage(running_old, fault_pn)) {
+        if (LoadProgramFault(running_old, fault_pn) == ERROR) {
+            TracePrintf(1, "[TrapMemory] Failed to load page: %d\n", fault_pn);
+            SyscallExit(_uctxt, ERROR);
+        }
+        memcpy(&running_old->uctxt, _uctxt, sizeof(UserContext));
+        return SUCCESS;
+    }
+
+    // 5. Otherwise, check to see if this unmapped page is between the heap and stack
     //    (i.e., if the fault is due to the stack growing).
     //
     //    Calculate the page number for the address that caused the fault, the brk (but add
     //    a page for the redzone buffer), and then find the current last valid stack page.
     int addr_pn = PTEAddressToPage(_uctxt->addr)     - MAX_PT_LEN;
     int brk_pn  = PTEAddressToPage(running_old->brk) - MAX_PT_LEN + 1;
-    int sp_pn   = 0;
-    for (int i = addr_pn; i < MAX_PT_LEN; i++) {
-        if (running_old->pt[i].valid) {
-            sp_pn = i;
-            break;
-        }
+    int sp_pn   = ProcessPTENext(running_old, addr_pn);
+    if (sp_pn == ERROR) {
+        sp_pn = 0;
     }
 
-    // 5. Check to see if the unmapped page the process is trying to touch is below
+    // 6. Check to see if the unmapped page the process is trying to touch is below
     //    the brk or above the stack. If so, this is not valid so abort the process.
     if (addr_pn < brk_pn || addr_pn > sp_pn) {
         TracePrintf(1, "[TrapMemory] Address out of bounds: %p\n", _uctxt->addr);
         SyscallExit(_uctxt, ERROR);
     }
 
-    // 6. Find free frames to grow the stack so that the address the process is trying to use
-    //    is valid. If we run out of memory, print a message and abort the process. Remember
-    //    to flush the TLB afterwards and to update the saved sp in the process' pcb.
+    // 7. Find free frames to grow the stack so that the address the process is trying to use
+    //    is valid (swapping back in any stack pages in between that were swapped out). If we run
+    //    out of memory, wait for the swapper if it can free some, otherwise print a message and
+    //    abort the process. Remember to flush the TLB afterwards and to update the saved sp in
+    //    the process' pcb.
     TracePrintf(1, "[TrapMemory] Growing process: %d stack.\n", running_old->pid);
     for (int start = addr_pn; start < sp_pn; start++) {
-        int pfn = FrameFindAndSet();
+        if (SwapIsSwapped(running_old, start)) {
+            if (SwapIn(running_old, start) == ERROR) {
+                TracePrintf(1, "[TrapMemory] Failed to swap in page: %d\n", start);
+                SyscallExit(_uctxt, ERROR);
+            }
+            continue;
+        }
+        int pfn;
+        while ((pfn = FrameAllocZero()) == ERROR && SwapWaitForFrame(running_old) == 0) {}
         if (pfn == ERROR) {
             TracePrintf(1, "[TrapMemory] Failed to find a free frame.\n");
             SyscallExit(_uctxt, ERROR);
         }
         TracePrintf(1, "[TrapMemory] Mapping page: %d to frame: %d\n", start, pfn);
-        PTESet(running_old->pt, start, PROT_READ | PROT_WRITE, pfn);
+        if (ProcessPTESet(running_old, start, PROT_READ | PROT_WRITE, pfn) == ERROR) {
+            TracePrintf(1, "[TrapMemory] Failed to map page: %d\n", start);
+            FrameClear(pfn);
+            SyscallExit(_uctxt, ERROR);
+        }
     }
     WriteRegister(REG_TLB_FLUSH, TLB_FLUSH_1);
     memcpy(&running_old->uctxt, _uctxt, sizeof(UserContext));
@@ -351,7 +441,8 @@ int TrapTTYTransmit(UserContext *_uctxt) {
 
 
 /*!
- * \desc              These requests are ignored (for now)
+ * \desc              This handler gets called when the disk finishes a sector transfer, which are
+ *                    only ever started by the swapper.
  * 
  * \param[in] _uctxt  The UserContext for the process associated with the TRAP
  * 
@@ -363,7 +454,10 @@ int TrapDisk(UserContext *_uctxt) {
         return ERROR;
     }
     TracePrintf(1, "[TrapDisk] _uctxt->sp: %p\t_uctxt->code: %d\n", _uctxt->sp, _uctxt->code);
-    return 0;
+
+    // 2. The only disk transfers we start are the swapper's, so let it finish (or continue) its
+    //    current page transfer.
+    return SwapDiskDone();
 }
 
 
@@ -14,12 +14,15 @@ int TrapKernel(UserContext *_uctxt);
 
 
 /*!
- * \desc              This handler gets called every time the clock interrupt fires---the time
- *                    between clock interrupts is the amount of time (i.e., quantum) that a process
- *                    gets to run for before being switched out. Before switching out the current
- *                    process, this handler updates our delay list (i.e., moves processes to the
- *                    ready list if they hit their delay value) and saves the current process'
- *                    UserContext in its pcb for future use.
+ * \desc              This handler gets called every time the clock interrupt fires. The scheduling
+ *                    policy decides whether the current process is switched out: under round
+ *                    robin and stride every tick, and under MLFQ a process at priority level L
+ *                    gets SCHEDULER_QUANTUM(L) ticks (or less if a higher priority process becomes
+ *                    ready). If nothing else is runnable, the current process simply keeps running
+ *                    without touching the ready lists or saving its UserContext. Before switching
+ *                    out the current process, this handler updates our delay list (i.e., moves
+ *                    processes to the ready list if they hit their delay value) and saves the
+ *                    current process' UserContext in its pcb for future use.
  * 
  * \param[in] _uctxt  The UserContext for the process associated with the TRAP
  * 
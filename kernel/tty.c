@@ -19,6 +19,8 @@ typedef struct line {
 typedef struct tty {
     int     read_pid;
     int     write_pid;
+    pcb_queue_t readers;        // Processes blocked waiting to read from the terminal (FIFO)
+    pcb_queue_t writers;        // Processes blocked waiting to write to the terminal (FIFO)
     int     read_buf_len;
     line_t *read_buf_start;
     line_t *read_buf_end;
@@ -29,6 +31,12 @@ typedef struct tty_list {
 } tty_list_t;
 
 
+/*
+ * Local Global Variable Definitions
+ */
+static slab_cache_t g_line_cache = SLAB_CACHE_INIT("line_t", sizeof(line_t), NULL);
+
+
 /*
  * Local Function Definitions
  */
@@ -73,6 +81,10 @@ static tty_t *TTYCreate() {
     // 2. Allocate space for our TTY read and write buffers
     terminal->read_pid       = 0;
     terminal->write_pid      = 0;
+    terminal->readers.start  = NULL;
+    terminal->readers.end    = NULL;
+    terminal->writers.start  = NULL;
+    terminal->writers.end    = NULL;
     terminal->read_buf_len   = 0;
     terminal->read_buf_start = NULL;
     terminal->read_buf_end   = NULL;
@@ -145,10 +157,10 @@ int TTYRead(tty_list_t *_tl, UserContext *_uctxt, int _tty_id, void *_usr_read_b
     // 3. Check that the user output read buffer is within valid memory space. Specifically, every
     //    byte of the buffer should be in the process' region 1 memory space (i.e., in valid pages)
     //    and have write permissions since we are supposed to write the tty data to it.
-    int ret = PTECheckAddress(running_old->pt,
-                              _usr_read_buf,
-                              _buf_len,
-                              PROT_WRITE);
+    int ret = ProcessCheckAddress(running_old,
+                                  _usr_read_buf,
+                                  _buf_len,
+                                  PROT_WRITE);
     if (ret < 0) {
         TracePrintf(1, "[TTYRead] _usr_read_buf is not within valid address space\n");
         return ERROR;
@@ -160,9 +172,8 @@ int TTYRead(tty_list_t *_tl, UserContext *_uctxt, int _tty_id, void *_usr_read_b
     if (terminal->read_pid) {
         TracePrintf(1, "[TTYRead] tty_id: %d already in use by process: %d. Blocking process: %d\n",
                                   _tty_id, terminal->read_pid, running_old->pid);
-        running_old->tty_id = _tty_id;
         memcpy(&running_old->uctxt, _uctxt, sizeof(UserContext));
-        SchedulerAddTTYRead(e_scheduler, running_old);
+        SchedulerAddTTYRead(e_scheduler, &terminal->readers, running_old);
         KCSwitch(_uctxt, running_old);
     }
 
@@ -176,10 +187,9 @@ int TTYRead(tty_list_t *_tl, UserContext *_uctxt, int _tty_id, void *_usr_read_b
     if (!terminal->read_buf_start) {
         TracePrintf(1, "[TTYRead] tty_id: %d read_buf empty. Blocking process: %d\n",
                                   _tty_id, running_old->pid);
-        running_old->tty_id = _tty_id;
         terminal->read_pid  = running_old->pid;
         memcpy(&running_old->uctxt, _uctxt, sizeof(UserContext));
-        SchedulerAddTTYRead(e_scheduler, running_old);
+        SchedulerAddTTYRead(e_scheduler, &terminal->readers, running_old);
         KCSwitch(_uctxt, running_old);
     }
 
@@ -207,7 +217,7 @@ int TTYRead(tty_list_t *_tl, UserContext *_uctxt, int _tty_id, void *_usr_read_b
     }
 
     // 8. Mark the terminal as available for reading and return the number of bytes read.
-    terminal->read_pid = SchedulerUpdateTTYRead(e_scheduler, _tty_id, terminal->read_pid);
+    terminal->read_pid = SchedulerUpdateTTYRead(e_scheduler, &terminal->readers, terminal->read_pid);
     return read_len;
 }
 
@@ -251,10 +261,10 @@ int TTYWrite(tty_list_t *_tl, UserContext *_uctxt, int _tty_id, void *_buf, int
     // 3. Check that the user output read buffer is within valid memory space. Specifically, every
     //    byte of the buffer should be in the process' region 1 memory space (i.e., in valid pages)
     //    and have read permissions since we are supposed to read the user data from it.
-    int ret = PTECheckAddress(running->pt,
-                              _buf,
-                              _len,
-                              PROT_READ);
+    int ret = ProcessCheckAddress(running,
+                                  _buf,
+                                  _len,
+                                  PROT_READ);
     if (ret < 0) {
         TracePrintf(1, "[TTYWrite] _buf is not within valid address space\n");
         return ERROR;
@@ -275,13 +285,11 @@ int TTYWrite(tty_list_t *_tl, UserContext *_uctxt, int _tty_id, void *_buf, int
 
     // 5. Check to see if there are already processes waiting on this device. If so, the current
     //    process to our TTYWrite blocked list---the current process will not run again until
-    //    all processes in the list ahead of it have finished using the tty device. Note that we
-    //    need to record the _tty_id the current process is blocking on so that we know to remove
-    //    it when the particular tty device becomes available.
-    running->tty_id = _tty_id;
+    //    all processes in the list ahead of it have finished using the tty device. Note that
+    //    each terminal has its own wait queue, so we only ever wake processes blocked on it.
     tty_t *terminal = _tl->terminals[_tty_id];
     if (terminal->write_pid) {
-        SchedulerAddTTYWrite(e_scheduler, running);
+        SchedulerAddTTYWrite(e_scheduler, &terminal->writers, running);
         KCSwitch(_uctxt, running);
     }
 
@@ -292,7 +300,7 @@ int TTYWrite(tty_list_t *_tl, UserContext *_uctxt, int _tty_id, void *_buf, int
     //     transmit it in one go and switch out
     if (kernel_buf_len <= TERMINAL_MAX_LINE) {
         TtyTransmit(_tty_id, kernel_buf, kernel_buf_len);
-        SchedulerAddTTYWrite(e_scheduler, running);
+        SchedulerAddTTYWrite(e_scheduler, &terminal->writers, running);
         KCSwitch(_uctxt, running);
     }
     // 7b. Otherwise, we break them up and transmit multiple times, blocking after each transmit
@@ -300,7 +308,7 @@ int TTYWrite(tty_list_t *_tl, UserContext *_uctxt, int _tty_id, void *_buf, int
         for (int rem = kernel_buf_len; rem > 0; rem -= TERMINAL_MAX_LINE) {
             int offset = kernel_buf_len - rem;
             TtyTransmit(_tty_id, kernel_buf + offset, rem > TERMINAL_MAX_LINE ? TERMINAL_MAX_LINE : rem);
-            SchedulerAddTTYWrite(e_scheduler, running);
+            SchedulerAddTTYWrite(e_scheduler, &terminal->writers, running);
             KCSwitch(_uctxt, running);
         }
     }
@@ -312,7 +320,7 @@ int TTYWrite(tty_list_t *_tl, UserContext *_uctxt, int _tty_id, void *_buf, int
     //    pid of the unblocked process which we save back into write_pid to ensure that the
     //    freshly unblocked process is the next to use the tty device. If there are no blocked
     //    processes, SchedulerUpdateTTYWrite will return 0.
-    terminal->write_pid = SchedulerUpdateTTYWrite(e_scheduler, _tty_id, 0);
+    terminal->write_pid = SchedulerUpdateTTYWrite(e_scheduler, &terminal->writers, 0);
     return kernel_buf_len;
 }
 
@@ -323,7 +331,7 @@ void TTYUpdateWriter(tty_list_t *_tl, UserContext *_uctxt, int _tty_id) {
     // tty device. Thus, even if other processes have been added to the wait list, it will skip
     // over them and unblock the write_pid process so that it can finish writing to the device.
     tty_t *terminal = _tl->terminals[_tty_id];
-    terminal->write_pid = SchedulerUpdateTTYWrite(e_scheduler, _tty_id, terminal->write_pid);
+    terminal->write_pid = SchedulerUpdateTTYWrite(e_scheduler, &terminal->writers, terminal->write_pid);
 }
 
 int TTYUpdateReader(tty_list_t *_tl, int _tty_id) {
@@ -360,7 +368,7 @@ int TTYUpdateReader(tty_list_t *_tl, int _tty_id) {
     //    to see if we have a process waiting to read from the specified terminal. If so,
     //    remove them from the TTYRead wait list and add them to the ready list.
     TTYLineAdd(terminal, read_buf, read_len);
-    terminal->read_pid = SchedulerUpdateTTYRead(e_scheduler, _tty_id, terminal->read_pid);
+    terminal->read_pid = SchedulerUpdateTTYRead(e_scheduler, &terminal->readers, terminal->read_pid);
     free(read_buf);
     return 0;
 }
@@ -377,7 +385,7 @@ static int TTYLineAdd(tty_t *_terminal, void *_buf, int _buf_len) {
     }
 
     // 2. Allocate space for a new line node.
-    line_t *line = (line_t *) malloc(sizeof(line_t));
+    line_t *line = (line_t *) SlabAlloc(&g_line_cache);
     if (!line) {
         TracePrintf(1, "[TTYLineAdd] Error allocating space for line\n");
         Halt();
@@ -429,7 +437,7 @@ static int TTYLineRemove(tty_t *_terminal) {
         _terminal->read_buf_start = NULL;
         _terminal->read_buf_end   = NULL;
         free(line->buf);
-        free(line);
+        SlabFree(&g_line_cache, line);
         return 0;
     }
 
@@ -439,6 +447,6 @@ static int TTYLineRemove(tty_t *_terminal) {
     _terminal->read_buf_start       = line->next;
     _terminal->read_buf_start->prev = NULL;
     free(line->buf);
-    free(line);
+    SlabFree(&g_line_cache, line);
     return 0;
 }
@@ -0,0 +1,67 @@
+#include "yuser.h"
+#include "yuser_ext.h"
+
+#define PIPE_LEN   (8 * PAGESIZE)       // Well above PIPE_BUFFER_LEN, so backed by kernel pages
+#define CHUNK_LEN  (3 * PAGESIZE + 123) // Odd sized, so the ring wraps in the middle of pages
+#define NUM_ROUNDS 4
+#define TOO_BIG    (64 * PAGESIZE)      // Above PIPE_MAX_LEN
+
+char g_out[PIPE_LEN];
+char g_in[PIPE_LEN];
+
+
+/*
+ * The parent creates a pipe with PipeInitSized, and the child writes NUM_ROUNDS full pipes'
+ * worth of a byte pattern into it in odd sized chunks. The parent reads it all back in different
+ * sized chunks and checks the pattern. Between rounds the pipe is drained, which frees its pages,
+ * so every round has the pages allocated again.
+ */
+int main() {
+    // 1. Pipes above PIPE_MAX_LEN should be turned down.
+    int pipe;
+    if (PipeInitSized(&pipe, TOO_BIG) != ERROR) {
+        TracePrintf(1, "[big_pipe_test] FAILED: created a pipe of %d bytes\n", TOO_BIG);
+    }
+    if (PipeInitSized(&pipe, PIPE_LEN) == ERROR) {
+        TracePrintf(1, "[big_pipe_test] FAILED: could not create a pipe of %d bytes\n", PIPE_LEN);
+        return 0;
+    }
+
+    // 2. The child writes each round in CHUNK_LEN chunks.
+    int pid = Fork();
+    if (!pid) {
+        for (int round = 0; round < NUM_ROUNDS; round++) {
+            for (int i = 0; i < PIPE_LEN; i++) {
+                g_out[i] = (char) (i * 7 + round);
+            }
+            for (int i = 0; i < PIPE_LEN; i += CHUNK_LEN) {
+                int len = PIPE_LEN - i < CHUNK_LEN ? PIPE_LEN - i : CHUNK_LEN;
+                PipeWrite(pipe, g_out + i, len);
+            }
+        }
+        Exit(0);
+    }
+
+    // 3. The parent reads each round back in whatever chunks come and checks the bytes.
+    for (int round = 0; round < NUM_ROUNDS; round++) {
+        int read = 0;
+        while (read < PIPE_LEN) {
+            int len = PipeRead(pipe, g_in + read, PIPE_LEN - read);
+            if (len == ERROR) {
+                TracePrintf(1, "[big_pipe_test] FAILED: PipeRead returned ERROR\n");
+                return 0;
+            }
+            read += len;
+        }
+        for (int i = 0; i < PIPE_LEN; i++) {
+            if (g_in[i] != (char) (i * 7 + round)) {
+                TracePrintf(1, "[big_pipe_test] FAILED: round %d byte %d is wrong\n", round, i);
+                break;
+            }
+        }
+        TracePrintf(1, "[big_pipe_test] Round %d: read %d bytes\n", round, read);
+    }
+    Wait(NULL);
+    Reclaim(pipe);
+    return 0;
+}
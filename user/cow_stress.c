@@ -0,0 +1,88 @@
+#include "yuser.h"
+
+#define NUM_PAGES    32
+#define NUM_CHILDREN 8
+
+
+// Checks the buffer, where page i should hold the byte i, except that (if _mine is set) the odd
+// pages should hold our own _fill + i. Returns ERROR if a byte is wrong.
+static int Check(char *_buf, int _mine, int _fill) {
+    for (int i = 0; i < NUM_PAGES * PAGESIZE; i++) {
+        int page = i / PAGESIZE;
+        char want = (char) ((page % 2 && _mine) ? _fill + page : page);
+        if (_buf[i] != want) {
+            TracePrintf(1, "[cow_stress] FAILED: pid %d page %d byte %d is %d not %d\n",
+                        GetPid(), page, i % PAGESIZE, _buf[i], want);
+            return ERROR;
+        }
+    }
+    return 0;
+}
+
+
+// Writes our own _fill + i into every odd page i.
+static void Scribble(char *_buf, int _fill) {
+    for (int page = 1; page < NUM_PAGES; page += 2) {
+        memset(_buf + page * PAGESIZE, _fill + page, PAGESIZE);
+    }
+}
+
+
+/*
+ * Meant to be run with little physical memory. The parent fills NUM_PAGES heap pages and forks
+ * NUM_CHILDREN children, and each child forks a grandchild of its own. Everyone checks that they
+ * see the parent's bytes, writes their own bytes into every other page (copying those pages) and
+ * checks the whole buffer again. Lastly the parent checks that none of the writes leaked into its
+ * own copy. A process that finds a wrong byte exits with ERROR.
+ */
+int main() {
+    // 1. Fill the buffer, page i with the byte i.
+    char *buf = malloc(NUM_PAGES * PAGESIZE);
+    if (!buf) {
+        TracePrintf(1, "[cow_stress] FAILED: malloc\n");
+        return 0;
+    }
+    for (int page = 0; page < NUM_PAGES; page++) {
+        memset(buf + page * PAGESIZE, page, PAGESIZE);
+    }
+
+    // 2. Fork the children (and grandchildren), which copy half of the pages each.
+    for (int i = 0; i < NUM_CHILDREN; i++) {
+        if (Fork()) {
+            continue;
+        }
+        int fill = 2 * i + 1;
+        int pid  = Fork();
+        if (!pid) {
+            fill++;
+        }
+        if (Check(buf, 0, 0) == ERROR) {
+            Exit(ERROR);
+        }
+        Scribble(buf, fill);
+        if (Check(buf, 1, fill) == ERROR) {
+            Exit(ERROR);
+        }
+        if (pid) {
+            int status;
+            Wait(&status);
+            Exit(status);
+        }
+        Exit(0);
+    }
+
+    // 3. Wait for everyone, then make sure our own pages are untouched.
+    int failed = 0;
+    for (int i = 0; i < NUM_CHILDREN; i++) {
+        int status;
+        Wait(&status);
+        failed += status == ERROR;
+    }
+    if (Check(buf, 0, 0) == ERROR || failed) {
+        TracePrintf(1, "[cow_stress] FAILED: %d children saw wrong bytes\n", failed);
+        return 0;
+    }
+    TracePrintf(1, "[cow_stress] Done: %d processes shared %d pages\n", 2 * NUM_CHILDREN + 1,
+                NUM_PAGES);
+    return 0;
+}
@@ -0,0 +1,74 @@
+#include "yuser.h"
+
+#define NUM_PAGES    16
+#define NUM_CHILDREN 6
+#define NUM_ROUNDS   3
+#define SLEEP_TICKS  20
+
+
+// Checks the buffer, where page i should hold the byte i, except that the odd pages should hold
+// _fill + i once we have written our own bytes into them. Returns ERROR if a byte is wrong.
+static int Check(char *_buf, int _fill) {
+    for (int i = 0; i < NUM_PAGES * PAGESIZE; i++) {
+        int page = i / PAGESIZE;
+        char want = (char) ((page % 2 && _fill) ? _fill + page : page);
+        if (_buf[i] != want) {
+            TracePrintf(1, "[merge_stress] FAILED: pid %d page %d byte %d is %d not %d\n",
+                        GetPid(), page, i % PAGESIZE, _buf[i], want);
+            return ERROR;
+        }
+    }
+    return 0;
+}
+
+
+/*
+ * The children each fill NUM_PAGES heap pages with the same bytes (page i holds the byte i, so
+ * page 0 is a zero page) and go to sleep together. While they sleep idle runs, and it should
+ * merge their pages. Each round they wake up, check their bytes, write their own bytes into the
+ * odd pages (unmerging them in the first round) and sleep again. Watch the merge counters in the
+ * TRACE. A child that finds a wrong byte exits with ERROR.
+ */
+int main() {
+    // 1. Fork the children, which fill their pages and then alternate sleeping and checking.
+    for (int i = 0; i < NUM_CHILDREN; i++) {
+        if (Fork()) {
+            continue;
+        }
+        char *buf = malloc(NUM_PAGES * PAGESIZE);
+        if (!buf) {
+            TracePrintf(1, "[merge_stress] FAILED: child %d could not malloc\n", GetPid());
+            Exit(ERROR);
+        }
+        for (int page = 0; page < NUM_PAGES; page++) {
+            memset(buf + page * PAGESIZE, page, PAGESIZE);
+        }
+        int fill = 0;
+        for (int round = 0; round < NUM_ROUNDS; round++) {
+            Delay(SLEEP_TICKS);
+            if (Check(buf, fill) == ERROR) {
+                Exit(ERROR);
+            }
+            fill = 16 * (i + 1) + round;
+            for (int page = 1; page < NUM_PAGES; page += 2) {
+                memset(buf + page * PAGESIZE, fill + page, PAGESIZE);
+            }
+        }
+        Exit(Check(buf, fill));
+    }
+
+    // 2. Wait for the children and count the failures.
+    int failed = 0;
+    for (int i = 0; i < NUM_CHILDREN; i++) {
+        int status;
+        Wait(&status);
+        failed += status == ERROR;
+    }
+    if (failed) {
+        TracePrintf(1, "[merge_stress] FAILED: %d children saw wrong bytes\n", failed);
+        return 0;
+    }
+    TracePrintf(1, "[merge_stress] Done: %d children shared %d identical pages each\n",
+                NUM_CHILDREN, NUM_PAGES);
+    return 0;
+}
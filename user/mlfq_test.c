@@ -0,0 +1,65 @@
+#include "yuser.h"
+#include "yuser_ext.h"
+
+#define NUM_LEVELS 4   // SCHEDULER_NUM_PRIORITIES in kernel/scheduler.h
+#define NUM_ROUNDS 10
+
+
+/*
+ * Run with sched=mlfq. The parent forks a child that spins and a child that keeps blocking, then
+ * watches their priority levels. The spinner uses up its quantum every time, so it should sink to
+ * the lowest level, while the sleeper should stay near the top. Afterwards, the parent checks the
+ * permission rules: it may lower its own priority but not raise it again, and it may raise the
+ * spinner's priority back up, but no higher than its own.
+ */
+int main() {
+    // 1. Fork the spinner and the sleeper. Neither ever exits on its own.
+    int spinner = Fork();
+    if (!spinner) {
+        while (1);
+    }
+    int sleeper = Fork();
+    if (!sleeper) {
+        while (1) {
+            Delay(1);
+        }
+    }
+
+    // 2. Watch the two sink (or not) through the levels.
+    for (int i = 0; i < NUM_ROUNDS; i++) {
+        Delay(2);
+        TracePrintf(1, "[mlfq_test] Round %d: spinner %d at level %d, sleeper %d at level %d\n",
+                    i, spinner, GetPriority(spinner), sleeper, GetPriority(sleeper));
+    }
+    if (GetPriority(spinner) != NUM_LEVELS - 1) {
+        TracePrintf(1, "[mlfq_test] FAILED: spinner was not demoted to the lowest level\n");
+    }
+    if (GetPriority(sleeper) >= GetPriority(spinner)) {
+        TracePrintf(1, "[mlfq_test] FAILED: sleeper sank as far as the spinner\n");
+    }
+
+    // 3. Lower our own priority, then make sure we can not raise it back up.
+    int mine = GetPriority(0);
+    if (mine < NUM_LEVELS - 1) {
+        if (SetPriority(0, mine + 1) == ERROR) {
+            TracePrintf(1, "[mlfq_test] FAILED: could not lower own priority\n");
+        }
+        if (SetPriority(0, mine) != ERROR) {
+            TracePrintf(1, "[mlfq_test] FAILED: raised own priority\n");
+        }
+        mine = GetPriority(0);
+    }
+
+    // 4. Raise the spinner up to our level, but not past it.
+    if (SetPriority(spinner, mine) == ERROR) {
+        TracePrintf(1, "[mlfq_test] FAILED: could not raise child to own level %d\n", mine);
+    }
+    if (mine > 0 && SetPriority(spinner, mine - 1) != ERROR) {
+        TracePrintf(1, "[mlfq_test] FAILED: raised child above own level %d\n", mine);
+    }
+    TracePrintf(1, "[mlfq_test] Done: parent at level %d, spinner at level %d\n",
+                mine, GetPriority(spinner));
+
+    // 5. Kill the children by exiting (init exiting halts the system).
+    return 0;
+}
@@ -0,0 +1,65 @@
+#include "yuser.h"
+
+#define NUM_READERS 4
+#define NUM_WRITERS 4
+#define NUM_MSGS    200
+
+
+/*
+ * The readers park on an empty pipe first, so most writes are handed straight to a waiting
+ * reader. Each message is one int (well under PIPE_ATOMIC_LEN, so messages never interleave), and
+ * every writer sends NUM_MSGS of them. Once the writers are done, the parent sends each reader a
+ * -1 to make it exit with the number of messages it got, and checks that none went missing.
+ */
+int main() {
+    // 1. Fork the readers, which count messages until they read a -1, and let them park.
+    int pipe;
+    PipeInit(&pipe);
+    int readers[NUM_READERS];
+    for (int i = 0; i < NUM_READERS; i++) {
+        readers[i] = Fork();
+        if (readers[i]) {
+            continue;
+        }
+        int count = 0;
+        int msg;
+        while (PipeRead(pipe, &msg, sizeof(msg)) == sizeof(msg) && msg != -1) {
+            count++;
+        }
+        Exit(count);
+    }
+    Delay(2);
+
+    // 2. Fork the writers, and wait for them to send all of their messages.
+    for (int i = 0; i < NUM_WRITERS; i++) {
+        if (Fork()) {
+            continue;
+        }
+        for (int msg = 0; msg < NUM_MSGS; msg++) {
+            PipeWrite(pipe, &msg, sizeof(msg));
+        }
+        Exit(0);
+    }
+    for (int i = 0; i < NUM_WRITERS; i++) {
+        Wait(NULL);
+    }
+
+    // 3. Stop the readers and add up what they got.
+    for (int i = 0; i < NUM_READERS; i++) {
+        int stop = -1;
+        PipeWrite(pipe, &stop, sizeof(stop));
+    }
+    int total = 0;
+    for (int i = 0; i < NUM_READERS; i++) {
+        int status;
+        int pid = Wait(&status);
+        TracePrintf(1, "[pipe_handoff_stress] Reader %d got %d messages\n", pid, status);
+        total += status;
+    }
+    if (total != NUM_WRITERS * NUM_MSGS) {
+        TracePrintf(1, "[pipe_handoff_stress] FAILED: %d of %d messages arrived\n",
+                    total, NUM_WRITERS * NUM_MSGS);
+    }
+    Reclaim(pipe);
+    return 0;
+}
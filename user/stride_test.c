@@ -0,0 +1,49 @@
+#include "yuser.h"
+#include "yuser_ext.h"
+
+#define NUM_CHILDREN 3
+#define WORK         20000000
+
+
+/*
+ * Run with sched=stride. Each child gives up some of its 100 inherited tickets (100, 50 and 25
+ * are left), makes sure it can not take them back, and then does the same amount of work. Their
+ * CPU shares are proportional to their tickets, so they should finish in order of their tickets,
+ * which the parent checks by reading their pids off of a pipe.
+ */
+int main() {
+    // 1. Fork the children, which report their pid on the pipe once their work is done.
+    int pipe;
+    int pids[NUM_CHILDREN];
+    PipeInit(&pipe);
+    for (int i = 0; i < NUM_CHILDREN; i++) {
+        pids[i] = Fork();
+        if (pids[i]) {
+            continue;
+        }
+        int tickets = 100 >> i;
+        if (SetTickets(0, tickets) == ERROR) {
+            TracePrintf(1, "[stride_test] FAILED: child could not lower its tickets\n");
+        }
+        if (SetTickets(0, tickets + 1) != ERROR) {
+            TracePrintf(1, "[stride_test] FAILED: child raised its own tickets\n");
+        }
+        for (volatile int j = 0; j < WORK; j++);
+        int pid = GetPid();
+        PipeWrite(pipe, &pid, sizeof(pid));
+        Exit(0);
+    }
+
+    // 2. Read off the pids as the children finish and compare against the ticket order.
+    for (int i = 0; i < NUM_CHILDREN; i++) {
+        int pid;
+        PipeRead(pipe, &pid, sizeof(pid));
+        TracePrintf(1, "[stride_test] Child %d (%d tickets) finished %d\n",
+                    pid, pid == pids[0] ? 100 : pid == pids[1] ? 50 : 25, i);
+        if (pid != pids[i]) {
+            TracePrintf(1, "[stride_test] FAILED: expected child %d to finish %d\n", pids[i], i);
+        }
+    }
+    while (Wait(NULL) != ERROR);
+    return 0;
+}
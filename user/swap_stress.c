@@ -0,0 +1,99 @@
+#include "yuser.h"
+
+#define NUM_PAGES    64
+#define NUM_CHILDREN 8
+#define NUM_ROUNDS   5
+
+
+// The expected byte i of the given page in the given round. A third of the pages are all zero, a
+// third repeat a short pattern (so zram compresses them well) and a third are pseudo random (so
+// they do not compress and have to stay resident or go to the disk).
+static char Byte(int _pid, int _page, int _round, int _i) {
+    switch ((_page + _round) % 3) {
+        case 0:
+            return 0;
+        case 1:
+            return (char) (_page + _i % 16);
+        default: {
+            unsigned int seed = ((unsigned int) _pid * 131 + _page) * 8191 + _round;
+            return (char) (((seed * 2654435761u) ^ (_i * 40503u)) * 2654435761u >> 24);
+        }
+    }
+}
+
+
+// Fills a page with its bytes for the given round.
+static void Fill(char *_page_buf, int _pid, int _page, int _round) {
+    for (int i = 0; i < PAGESIZE; i++) {
+        _page_buf[i] = Byte(_pid, _page, _round, i);
+    }
+}
+
+
+// Checks a page against its bytes for the given round. Returns ERROR if a byte is wrong.
+static int Check(char *_page_buf, int _pid, int _page, int _round) {
+    for (int i = 0; i < PAGESIZE; i++) {
+        if (_page_buf[i] != Byte(_pid, _page, _round, i)) {
+            TracePrintf(1, "[swap_stress] FAILED: pid %d page %d byte %d round %d\n",
+                        _pid, _page, i, _round);
+            return ERROR;
+        }
+    }
+    return 0;
+}
+
+
+/*
+ * Meant to be run with less physical memory than the NUM_CHILDREN * NUM_PAGES pages that the
+ * children hold between them, so that the kernel has to swap (try swap=zram and swap=disk). Each
+ * child fills its pages with zero, compressible and incompressible bytes, then keeps sleeping (so
+ * that it gets evicted), checking every page (so that it faults them back in) and rewriting a
+ * third of them. A child that finds a wrong byte exits with ERROR.
+ */
+int main() {
+    // 1. Fork the children, which each fill, check and rewrite their own pages.
+    for (int i = 0; i < NUM_CHILDREN; i++) {
+        if (Fork()) {
+            continue;
+        }
+        int   pid = GetPid();
+        char *buf = malloc(NUM_PAGES * PAGESIZE);
+        if (!buf) {
+            TracePrintf(1, "[swap_stress] FAILED: child %d could not malloc\n", pid);
+            Exit(ERROR);
+        }
+        int rounds[NUM_PAGES];
+        for (int page = 0; page < NUM_PAGES; page++) {
+            Fill(buf + page * PAGESIZE, pid, page, 0);
+            rounds[page] = 0;
+        }
+        for (int round = 1; round <= NUM_ROUNDS; round++) {
+            Delay(1);
+            for (int page = 0; page < NUM_PAGES; page++) {
+                if (Check(buf + page * PAGESIZE, pid, page, rounds[page]) == ERROR) {
+                    Exit(ERROR);
+                }
+                if (page % 3 == round % 3) {
+                    Fill(buf + page * PAGESIZE, pid, page, round);
+                    rounds[page] = round;
+                }
+            }
+        }
+        Exit(0);
+    }
+
+    // 2. Wait for the children and count the failures.
+    int failed = 0;
+    for (int i = 0; i < NUM_CHILDREN; i++) {
+        int status;
+        Wait(&status);
+        failed += status == ERROR;
+    }
+    if (failed) {
+        TracePrintf(1, "[swap_stress] FAILED: %d children saw wrong bytes\n", failed);
+        return 0;
+    }
+    TracePrintf(1, "[swap_stress] Done: %d children touched %d pages each\n", NUM_CHILDREN,
+                NUM_PAGES);
+    return 0;
+}
@@ -0,0 +1,56 @@
+#include "yuser.h"
+#include "yuser_ext.h"
+
+#define BSS_PAGES  16
+#define HEAP_PAGES 16
+
+char g_bss[BSS_PAGES * PAGESIZE];   // Makes our data segment much bigger than vfork_test's
+
+
+/*
+ * The parent grows its heap, then spawns a child with Vfork that execs a different program
+ * (vfork_test, whose data segment is much smaller). After getting its region 1 back, the parent
+ * grows its heap further and checks that all of its old bytes are still there, which only works
+ * if it got its own brk back along with its region 1 rather than the exec'd program's.
+ */
+int main() {
+    // 1. Fill the bss and some heap.
+    memset(g_bss, 'b', sizeof(g_bss));
+    char *before = malloc(HEAP_PAGES * PAGESIZE);
+    if (!before) {
+        TracePrintf(1, "[vfork_brk_test] FAILED: malloc before Vfork\n");
+        return 0;
+    }
+    memset(before, 'h', HEAP_PAGES * PAGESIZE);
+
+    // 2. Spawn the child, which execs a program with a different layout.
+    int pid = Vfork();
+    if (!pid) {
+        char *argvec[3];
+        argvec[0] = "./user/vfork_test";
+        argvec[1] = "child";
+        argvec[2] = NULL;
+        Exec(argvec[0], argvec);
+        TracePrintf(1, "[vfork_brk_test] FAILED: child could not exec %s\n", argvec[0]);
+        Exit(ERROR);
+    }
+    Wait(NULL);
+
+    // 3. Grow the heap again, then check the old bytes and give the new ones back.
+    char *after = malloc(HEAP_PAGES * PAGESIZE);
+    if (!after) {
+        TracePrintf(1, "[vfork_brk_test] FAILED: malloc after Vfork\n");
+        return 0;
+    }
+    memset(after, 'a', HEAP_PAGES * PAGESIZE);
+    for (int i = 0; i < HEAP_PAGES * PAGESIZE; i++) {
+        if (g_bss[i] != 'b' || before[i] != 'h' || after[i] != 'a') {
+            TracePrintf(1, "[vfork_brk_test] FAILED: byte %d changed\n", i);
+            return 0;
+        }
+    }
+    free(after);
+    free(before);
+    TracePrintf(1, "[vfork_brk_test] Done: heap grew past %p after Vfork\n", after);
+    return 0;
+}
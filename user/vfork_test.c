@@ -0,0 +1,58 @@
+#include "yuser.h"
+#include "yuser_ext.h"
+
+#define NUM_SPAWNS  20
+#define EXEC_STATUS 7
+
+int g_shared = 0;
+
+
+/*
+ * The parent spawns NUM_SPAWNS children with Vfork. Each child writes its pid into g_shared,
+ * which the parent should see since the child ran in its address space, and then execs this
+ * program again with an extra argument. The exec'd copy simply exits with EXEC_STATUS. One last
+ * child exits without exec'ing, which should also wake up the parent.
+ */
+int main(int argc, char **argv) {
+    // 1. The exec'd copy of ourselves only has to exit.
+    if (argc > 1) {
+        Exit(EXEC_STATUS);
+    }
+
+    // 2. Spawn the children one after another. We are blocked until each one calls Exec, and the
+    //    children must not return from main since they share our stack until then.
+    for (int i = 0; i < NUM_SPAWNS; i++) {
+        int pid = Vfork();
+        if (pid == ERROR) {
+            TracePrintf(1, "[vfork_test] FAILED: Vfork returned ERROR\n");
+            return 0;
+        }
+        if (!pid) {
+            char *argvec[3];
+            argvec[0] = "./user/vfork_test";
+            argvec[1] = "child";
+            argvec[2] = NULL;
+            g_shared  = GetPid();
+            Exec(argvec[0], argvec);
+            TracePrintf(1, "[vfork_test] FAILED: child could not exec %s\n", argvec[0]);
+            Exit(ERROR);
+        }
+        if (g_shared != pid) {
+            TracePrintf(1, "[vfork_test] FAILED: did not see child %d's write\n", pid);
+        }
+        int status;
+        Wait(&status);
+        if (status != EXEC_STATUS) {
+            TracePrintf(1, "[vfork_test] FAILED: child %d exited with %d\n", pid, status);
+        }
+    }
+
+    // 3. A child that exits straight away gives our address space back too.
+    int pid = Vfork();
+    if (!pid) {
+        Exit(0);
+    }
+    Wait(NULL);
+    TracePrintf(1, "[vfork_test] Done: spawned %d children with Vfork\n", NUM_SPAWNS + 1);
+    return 0;
+}
@@ -0,0 +1,64 @@
+#ifndef __YUSER_EXT_H
+#define __YUSER_EXT_H
+
+// User side wrappers for our kernel specific syscalls (see kernel/syscall.h), which libuser.a
+// knows nothing about. Like the libuser wrappers, each one traps into the kernel with the syscall
+// code in %eax and its arguments in %ebx and %ecx, which TrapKernel finds in the UserContext as
+// code, regs[0] and regs[1]. The kernel's return value comes back in %eax.
+//
+// The wrappers are always inlined, so they never push a frame of their own. Vfork depends on this,
+// since its child runs on the parent's stack until it calls Exec or Exit.
+
+// Syscall codes (these must match kernel/syscall.h)
+#define YALNIX_SET_PRIORITY    0x70
+#define YALNIX_GET_PRIORITY    0x71
+#define YALNIX_SET_TICKETS     0x72
+#define YALNIX_VFORK           0x73
+#define YALNIX_PIPE_INIT_SIZED 0x74
+
+#define YUSER_EXT_INLINE static inline __attribute__((always_inline))
+
+
+YUSER_EXT_INLINE int YalnixTrap(int _code, int _arg0, int _arg1) {
+    int ret;
+    __asm__ volatile ("int $0x80"
+                      : "=a" (ret)
+                      : "a" (_code), "b" (_arg0), "c" (_arg1)
+                      : "memory");
+    return ret;
+}
+
+
+// Sets the MLFQ priority level of _pid (0 for the caller). Returns 0 on success, ERROR otherwise.
+YUSER_EXT_INLINE int SetPriority(int _pid, int _priority) {
+    return YalnixTrap(YALNIX_SET_PRIORITY, _pid, _priority);
+}
+
+
+// Returns the MLFQ priority level of _pid (0 for the caller), or ERROR.
+YUSER_EXT_INLINE int GetPriority(int _pid) {
+    return YalnixTrap(YALNIX_GET_PRIORITY, _pid, 0);
+}
+
+
+// Sets the stride scheduling tickets of _pid (0 for the caller). Returns 0 on success, ERROR
+// otherwise.
+YUSER_EXT_INLINE int SetTickets(int _pid, int _tickets) {
+    return YalnixTrap(YALNIX_SET_TICKETS, _pid, _tickets);
+}
+
+
+// Creates a child that runs in the caller's address space while the caller blocks, until the child
+// calls Exec or Exit. Returns the child's pid to the parent, 0 to the child, and ERROR otherwise.
+YUSER_EXT_INLINE int Vfork(void) {
+    return YalnixTrap(YALNIX_VFORK, 0, 0);
+}
+
+
+// Creates a pipe that holds up to _size bytes (at most PIPE_MAX_LEN) and stores its id in
+// *_pipe_id. Returns 0 on success, ERROR otherwise.
+YUSER_EXT_INLINE int PipeInitSized(int *_pipe_id, int _size) {
+    return YalnixTrap(YALNIX_PIPE_INIT_SIZED, (int) _pipe_id, _size);
+}
+
+#endif // __YUSER_EXT_H